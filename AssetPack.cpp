@@ -0,0 +1,96 @@
+#include "AssetPack.hpp"
+
+#include "asset_cache.hpp"
+#include "compress_lz4.hpp"
+#include "data_path.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+AssetPack::AssetPack(std::string const &filename) : file(filename, MappedFile::FileOnly()) {
+	directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+
+	if (file.size < sizeof(Header)) throw std::runtime_error("Asset pack '" + filename + "' is too small to have a header.");
+	Header header;
+	std::memcpy(&header, file.data, sizeof(header));
+	if (std::string(header.magic, 4) != "pak0") throw std::runtime_error("Asset pack '" + filename + "' has the wrong magic number.");
+
+	if (header.entries_offset % alignof(Entry) != 0
+	 || header.entries_offset > file.size
+	 || (file.size - header.entries_offset) / sizeof(Entry) < header.count
+	 || header.names_offset > file.size
+	 || file.size - header.names_offset < header.names_size) {
+		throw std::runtime_error("Asset pack '" + filename + "' has an out-of-range table of contents.");
+	}
+	entries = std::span< Entry const >(reinterpret_cast< Entry const * >(file.data + header.entries_offset), header.count);
+	names = std::span< char const >(file.data + header.names_offset, header.names_size);
+
+	for (auto const &entry : entries) {
+		if (!(entry.name_begin <= entry.name_end && entry.name_end <= names.size())
+		 || entry.offset % Alignment != 0
+		 || entry.offset > file.size
+		 || file.size - entry.offset < entry.stored_size
+		 || entry.compression > LZ4
+		 || (entry.compression == Uncompressed && entry.stored_size != entry.size)) {
+			throw std::runtime_error("Asset pack '" + filename + "' has a malformed entry.");
+		}
+	}
+	if (!std::is_sorted(entries.begin(), entries.end(), [](Entry const &a, Entry const &b) { return a.name_hash < b.name_hash; })) {
+		throw std::runtime_error("Asset pack '" + filename + "' has an unsorted table of contents.");
+	}
+
+	checked.reset(new std::atomic< bool >[entries.size()]);
+	for (size_t i = 0; i < entries.size(); ++i) {
+		checked[i] = false;
+	}
+}
+
+AssetPack::Entry const *AssetPack::find(std::string const &name) const {
+	uint64_t hash = hash_bytes(name.data(), name.size());
+	auto f = std::lower_bound(entries.begin(), entries.end(), hash, [](Entry const &entry, uint64_t h) {
+		return entry.name_hash < h;
+	});
+	for (; f != entries.end() && f->name_hash == hash; ++f) {
+		if (std::string(names.data() + f->name_begin, names.data() + f->name_end) == name) return &*f;
+	}
+	return nullptr;
+}
+
+bool AssetPack::view(std::string const &filename, MappedFile *into) const {
+	if (filename.compare(0, directory.size(), directory) != 0) return false;
+	std::string name = filename.substr(directory.size());
+	std::replace(name.begin(), name.end(), '\\', '/');
+
+	Entry const *entry = find(name);
+	if (!entry) return false;
+
+	std::span< uint8_t const > stored(reinterpret_cast< uint8_t const * >(file.data + entry->offset), entry->stored_size);
+	if (entry->compression == LZ4) {
+		std::vector< uint8_t > contents;
+		decompress_lz4(stored, std::span< uint8_t const >(), entry->size, &contents);
+		into->owned = std::move(contents);
+		into->data = reinterpret_cast< char const * >(into->owned.data());
+	} else {
+		into->data = reinterpret_cast< char const * >(stored.data());
+	}
+	into->size = entry->size;
+
+	std::atomic< bool > &entry_checked = checked[entry - entries.data()];
+	if (!entry_checked) {
+		if (hash_bytes(into->data, into->size) != entry->checksum) {
+			throw std::runtime_error("Entry '" + name + "' in asset pack '" + file.filename + "' failed its checksum.");
+		}
+		entry_checked = true;
+	}
+	return true;
+}
+
+AssetPack const *AssetPack::get() {
+	static std::unique_ptr< AssetPack > pack = []() -> std::unique_ptr< AssetPack > {
+		std::string filename = data_path("assets.pack");
+		std::error_code ec;
+		if (!std::filesystem::exists(filename, ec)) return nullptr;
+		return std::make_unique< AssetPack >(filename);
+	}();
+	return pack.get();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+ * An AssetPack is one file holding many assets (made from files in dist/ by
+ *  the pack-assets tool -- see Maekfile.js), so startup opens and maps one
+ *  file instead of one per asset, and the OS can read ahead through all of
+ *  it at once.
+ *
+ * Layout:
+ *  Header
+ *  entry contents, each starting at a multiple of 'Alignment' (so chunk
+ *   contents can be used in place)
+ *  Entry[count], sorted by name_hash (looked up by binary search)
+ *  names (utf8, not terminated; entries refer to [name_begin, name_end))
+ *
+ * Entries may be LZ4-compressed (see compress_lz4.hpp) and carry a
+ *  hash_bytes() checksum of their uncompressed contents, which is checked
+ *  the first time each entry is viewed.
+ *
+ * MappedFile looks files up in AssetPack::get() (the pack at
+ *  data_path("assets.pack"), if there is one) before opening them, so
+ *  loaders that go through MappedFile read from the pack without changes.
+ */
+
+#include "MappedFile.hpp"
+
+#include <atomic>
+#include <memory>
+#include <span>
+#include <string>
+#include <cstdint>
+
+struct AssetPack {
+	//open a pack; throws if it is malformed:
+	AssetPack(std::string const &filename);
+
+	struct Header {
+		char magic[4]; //"pak0"
+		uint32_t count; //number of entries
+		uint64_t entries_offset;
+		uint64_t names_offset;
+		uint64_t names_size;
+	};
+	static_assert(sizeof(Header) == 32, "Header is packed.");
+
+	struct Entry {
+		uint64_t name_hash; //hash_bytes() of the name
+		uint64_t offset; //where the (stored) contents start
+		uint64_t stored_size; //size in the pack
+		uint64_t size; //size once uncompressed
+		uint64_t checksum; //hash_bytes() of the uncompressed contents
+		uint32_t name_begin, name_end;
+		uint32_t compression; //one of the values below
+		uint32_t padding_;
+	};
+	static_assert(sizeof(Entry) == 56, "Entry is packed.");
+
+	enum : uint32_t { Uncompressed = 0, LZ4 = 1 };
+	enum : uint64_t { Alignment = 16 };
+
+	//entry with the given name (relative to the pack's directory, '/'-separated), or nullptr:
+	Entry const *find(std::string const &name) const;
+
+	//if 'filename' (under the pack's directory, as data_path() makes) is in the pack, point 'into' at its contents:
+	// returns false if it isn't; throws if the entry fails its checksum
+	bool view(std::string const &filename, MappedFile *into) const;
+
+	//the pack at data_path("assets.pack"), or nullptr if there isn't one:
+	static AssetPack const *get();
+
+	MappedFile file;
+	std::string directory; //names are relative to this (includes trailing '/')
+	std::span< Entry const > entries;
+	std::span< char const > names;
+	std::unique_ptr< std::atomic< bool >[] > checked; //has entries[i]'s checksum been verified?
+};
@@ -0,0 +1,264 @@
+#include "BVH.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+static BVH::Box merge(BVH::Box const &a, BVH::Box const &b) {
+	BVH::Box ret;
+	ret.min = glm::min(a.min, b.min);
+	ret.max = glm::max(a.max, b.max);
+	return ret;
+}
+
+void BVH::build(std::vector< Box > const &boxes) {
+	item_boxes = boxes;
+	item_leaf.assign(boxes.size(), 0);
+
+	//items are shuffled around along with a copy of their boxes, so partitioning reads memory in order:
+	struct Ref {
+		Box box;
+		uint32_t item;
+	};
+	std::vector< Ref > refs(boxes.size());
+	for (uint32_t i = 0; i < refs.size(); ++i) {
+		refs[i].box = boxes[i];
+		refs[i].item = i;
+	}
+
+	nodes.clear();
+	nodes.reserve(2 * (boxes.size() / (LeafSize / 2) + 1));
+	nodes.emplace_back();
+	nodes[0].end = uint32_t(refs.size());
+
+	//split nodes until they are small enough to be leaves:
+	// (median split of item centers along the longest axis -- simple, and good enough for culling)
+	std::vector< uint32_t > todo;
+	todo.emplace_back(0);
+	while (!todo.empty()) {
+		uint32_t n = todo.back();
+		todo.pop_back();
+		uint32_t begin = nodes[n].begin;
+		uint32_t end = nodes[n].end;
+
+		if (end - begin <= LeafSize) {
+			Box box;
+			for (uint32_t i = begin; i < end; ++i) {
+				box = merge(box, refs[i].box);
+				item_leaf[refs[i].item] = n;
+			}
+			nodes[n].box = box;
+			continue;
+		}
+
+		Box centers; //(actually 2x centers -- min + max -- which is fine for picking an axis)
+		for (uint32_t i = begin; i < end; ++i) {
+			glm::vec3 center = refs[i].box.min + refs[i].box.max;
+			centers.min = glm::min(centers.min, center);
+			centers.max = glm::max(centers.max, center);
+		}
+
+		glm::vec3 extent = centers.max - centers.min;
+		int axis = 0;
+		if (extent.y > extent[axis]) axis = 1;
+		if (extent.z > extent[axis]) axis = 2;
+
+		uint32_t mid = begin + (end - begin) / 2;
+		std::nth_element(refs.begin() + begin, refs.begin() + mid, refs.begin() + end, [axis](Ref const &a, Ref const &b) {
+			return a.box.min[axis] + a.box.max[axis] < b.box.min[axis] + b.box.max[axis];
+		});
+
+		uint32_t children = uint32_t(nodes.size());
+		nodes[n].children = children;
+		nodes.emplace_back();
+		nodes.emplace_back();
+		nodes[children].begin = begin;
+		nodes[children].end = mid;
+		nodes[children].parent = n;
+		nodes[children+1].begin = mid;
+		nodes[children+1].end = end;
+		nodes[children+1].parent = n;
+
+		todo.emplace_back(children+1);
+		todo.emplace_back(children);
+	}
+
+	//internal node boxes, children first:
+	for (uint32_t n = uint32_t(nodes.size()) - 1; n < nodes.size(); --n) {
+		if (nodes[n].children) {
+			nodes[n].box = merge(nodes[nodes[n].children].box, nodes[nodes[n].children+1].box);
+		}
+	}
+
+	items.resize(refs.size());
+	for (uint32_t i = 0; i < refs.size(); ++i) {
+		items[i] = refs[i].item;
+	}
+
+	dirty.clear();
+	node_dirty.assign(nodes.size(), 0);
+}
+
+void BVH::update(uint32_t item, Box const &box) {
+	assert(item < item_boxes.size());
+	item_boxes[item] = box;
+
+	//mark the item's leaf and everything above it (stopping at nodes that are already marked):
+	for (uint32_t n = item_leaf[item]; n != -1U && !node_dirty[n]; n = nodes[n].parent) {
+		node_dirty[n] = 1;
+		dirty.emplace_back(n);
+	}
+}
+
+void BVH::refit() {
+	if (dirty.empty()) return;
+
+	auto refit_node = [this](uint32_t n) {
+		Node &node = nodes[n];
+		node_dirty[n] = 0;
+		if (node.children) {
+			node.box = merge(nodes[node.children].box, nodes[node.children+1].box);
+		} else {
+			Box box;
+			for (uint32_t i = node.begin; i < node.end; ++i) {
+				box = merge(box, item_boxes[items[i]]);
+			}
+			node.box = box;
+		}
+	};
+
+	//children come after their parents in 'nodes', so handling nodes last-to-first does children first:
+	if (dirty.size() * 16 > nodes.size()) {
+		//lots of nodes to fix; cheaper to sweep them all than to sort the list:
+		for (uint32_t n = uint32_t(nodes.size()) - 1; n < nodes.size(); --n) {
+			if (node_dirty[n]) refit_node(n);
+		}
+	} else {
+		std::sort(dirty.begin(), dirty.end(), [](uint32_t a, uint32_t b) { return a > b; });
+		for (uint32_t n : dirty) refit_node(n);
+	}
+	dirty.clear();
+}
+
+void BVH::query(Frustum const &frustum, std::vector< uint32_t > *out_) const {
+	assert(out_);
+	auto &out = *out_;
+	if (nodes.empty() || items.empty()) return;
+
+	auto center_radius = [](Box const &box, glm::vec3 *center, glm::vec3 *radius) {
+		*center = 0.5f * (box.max + box.min);
+		*radius = 0.5f * (box.max - box.min);
+	};
+
+	uint32_t stack[64];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top) {
+		Node const &node = nodes[stack[--top]];
+
+		glm::vec3 center, radius;
+		center_radius(node.box, &center, &radius);
+		if (!frustum.overlaps(center, radius)) continue;
+
+		if (frustum.contains(center, radius)) {
+			//everything below is visible:
+			out.insert(out.end(), items.begin() + node.begin, items.begin() + node.end);
+		} else if (node.children) {
+			assert(top + 2 <= 64);
+			stack[top++] = node.children + 1;
+			stack[top++] = node.children;
+		} else {
+			for (uint32_t i = node.begin; i < node.end; ++i) {
+				center_radius(item_boxes[items[i]], &center, &radius);
+				if (frustum.overlaps(center, radius)) out.emplace_back(items[i]);
+			}
+		}
+	}
+}
+
+//slab test: does the ray enter 'box' within [0, max_t]? (if so, *t is where)
+static bool ray_enter(BVH::Box const &box, glm::vec3 const &origin, glm::vec3 const &inv_direction, float max_t, float *t) {
+	float t_min = 0.0f;
+	float t_max = max_t;
+	for (int c = 0; c < 3; ++c) {
+		float t0 = (box.min[c] - origin[c]) * inv_direction[c];
+		float t1 = (box.max[c] - origin[c]) * inv_direction[c];
+		if (t0 > t1) std::swap(t0, t1);
+		//(written so that NaNs -- from a ray lying exactly in a slab's plane -- leave the range alone)
+		t_min = (t0 > t_min ? t0 : t_min);
+		t_max = (t1 < t_max ? t1 : t_max);
+	}
+	*t = t_min;
+	return t_min <= t_max;
+}
+
+void BVH::query(glm::vec3 const &origin, glm::vec3 const &direction, float max_t, std::vector< uint32_t > *out_) const {
+	assert(out_);
+	auto &out = *out_;
+	if (nodes.empty() || items.empty()) return;
+
+	glm::vec3 inv_direction = 1.0f / direction;
+	float t;
+
+	uint32_t stack[64];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top) {
+		Node const &node = nodes[stack[--top]];
+		if (!ray_enter(node.box, origin, inv_direction, max_t, &t)) continue;
+
+		if (node.children) {
+			assert(top + 2 <= 64);
+			stack[top++] = node.children + 1;
+			stack[top++] = node.children;
+		} else {
+			for (uint32_t i = node.begin; i < node.end; ++i) {
+				if (ray_enter(item_boxes[items[i]], origin, inv_direction, max_t, &t)) out.emplace_back(items[i]);
+			}
+		}
+	}
+}
+
+uint32_t BVH::pick(glm::vec3 const &origin, glm::vec3 const &direction, float max_t, float *t_) const {
+	uint32_t best = -1U;
+	float best_t = max_t;
+	if (nodes.empty() || items.empty()) return best;
+
+	glm::vec3 inv_direction = 1.0f / direction;
+	float t;
+
+	uint32_t stack[64];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top) {
+		Node const &node = nodes[stack[--top]];
+		if (!ray_enter(node.box, origin, inv_direction, best_t, &t)) continue;
+
+		if (node.children) {
+			//visit the nearer child first, so more of the farther one can be skipped:
+			float t0 = std::numeric_limits< float >::infinity();
+			float t1 = std::numeric_limits< float >::infinity();
+			bool hit0 = ray_enter(nodes[node.children].box, origin, inv_direction, best_t, &t0);
+			bool hit1 = ray_enter(nodes[node.children+1].box, origin, inv_direction, best_t, &t1);
+			assert(top + 2 <= 64);
+			if (hit0 && hit1) {
+				stack[top++] = (t0 <= t1 ? node.children + 1 : node.children);
+				stack[top++] = (t0 <= t1 ? node.children : node.children + 1);
+			} else if (hit0) {
+				stack[top++] = node.children;
+			} else if (hit1) {
+				stack[top++] = node.children + 1;
+			}
+		} else {
+			for (uint32_t i = node.begin; i < node.end; ++i) {
+				if (ray_enter(item_boxes[items[i]], origin, inv_direction, best_t, &t)
+				 && (best == -1U || t < best_t)) {
+					best = items[i];
+					best_t = t;
+				}
+			}
+		}
+	}
+
+	if (t_ && best != -1U) *t_ = best_t;
+	return best;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+ * A BVH (bounding volume hierarchy) is a binary tree of axis-aligned boxes
+ *  over a set of 'items' (numbered 0 .. N-1), for answering "which items
+ *  might be visible / hit by this ray" in much less than O(N) time.
+ *
+ * build() makes the tree from scratch (use when items are added/removed);
+ *  update() + refit() adjust boxes in place when items move (the tree shape
+ *  gets worse as things move around, so rebuild now and then if that matters).
+ *
+ * Scene uses one of these over its drawables' world-space bounds.
+ */
+
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+struct BVH {
+	struct Box {
+		glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+	};
+
+	//make the tree for items with the given boxes (item i has boxes[i]):
+	void build(std::vector< Box > const &boxes);
+
+	//change an item's box (takes effect in queries after refit()):
+	void update(uint32_t item, Box const &box);
+	//bring the boxes of nodes above updated items up to date:
+	void refit();
+
+	//append every item whose box overlaps 'frustum' to 'out':
+	void query(Frustum const &frustum, std::vector< uint32_t > *out) const;
+
+	//append every item whose box is hit by the ray origin + t * direction, t in [0, max_t], to 'out':
+	void query(glm::vec3 const &origin, glm::vec3 const &direction, float max_t, std::vector< uint32_t > *out) const;
+
+	//item whose box is hit first by the ray origin + t * direction, t in [0, max_t]:
+	// returns -1U if nothing is hit; sets *t to the distance (in units of 'direction') to the box
+	uint32_t pick(glm::vec3 const &origin, glm::vec3 const &direction, float max_t, float *t = nullptr) const;
+
+	uint32_t size() const { return uint32_t(item_boxes.size()); }
+
+	//internals:
+	struct Node {
+		Box box;
+		uint32_t begin = 0, end = 0; //range of 'items' under this node
+		uint32_t children = 0; //0 for leaves; otherwise, children are nodes[children] and nodes[children+1]
+		uint32_t parent = -1U;
+	};
+	std::vector< Node > nodes; //nodes[0] is the root; children always come after their parents
+	std::vector< uint32_t > items; //item indices, ordered so every node's items are contiguous
+	std::vector< Box > item_boxes;
+	std::vector< uint32_t > item_leaf; //leaf node that holds each item
+	std::vector< uint32_t > dirty; //nodes whose boxes need refit()
+	std::vector< uint8_t > node_dirty;
+
+	enum : uint32_t { LeafSize = 4 }; //most items per leaf
+};
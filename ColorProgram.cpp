@@ -3,11 +3,14 @@
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
 
-Load< ColorProgram > color_program(LoadTagEarly);
+Load< ColorProgram > color_program(LoadTagEarly, LoadSubmitFirst(), ColorProgram::submit, [](GLProgramBuild &&build) -> ColorProgram const * {
+	return new ColorProgram(std::move(build));
+});
 
-ColorProgram::ColorProgram() {
-	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
-	program = gl_compile_program(
+GLProgramBuild ColorProgram::submit() {
+	//Start compiling vertex and fragment shaders using the convenient 'gl_submit_program' helper function:
+	// (the constructor waits for the result)
+	return gl_submit_program(
 		//vertex shader:
 		"#version 330\n"
 		"uniform mat4 OBJECT_TO_CLIP;\n"
@@ -29,6 +32,11 @@ ColorProgram::ColorProgram() {
 	);
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
+}
+
+ColorProgram::ColorProgram(GLProgramBuild &&build) {
+	//wait for the shaders submitted by submit() to finish compiling:
+	program = gl_await_program(std::move(build));
 
 	//look up the locations of vertex attributes:
 	Position_vec4 = glGetAttribLocation(program, "Position");
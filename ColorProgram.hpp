@@ -1,11 +1,14 @@
 #pragma once
 
 #include "GL.hpp"
+#include "gl_compile_program.hpp"
 #include "Load.hpp"
 
 //Shader program that draws transformed, colored vertices:
 struct ColorProgram {
-	ColorProgram();
+	//start compiling the shaders (see gl_submit_program); the constructor waits for them to finish:
+	static GLProgramBuild submit();
+	ColorProgram(GLProgramBuild &&build = submit());
 	~ColorProgram();
 
 	GLuint program = 0;
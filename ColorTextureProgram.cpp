@@ -3,11 +3,14 @@
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
 
-Load< ColorTextureProgram > color_texture_program(LoadTagEarly);
+Load< ColorTextureProgram > color_texture_program(LoadTagEarly, LoadSubmitFirst(), ColorTextureProgram::submit, [](GLProgramBuild &&build) -> ColorTextureProgram const * {
+	return new ColorTextureProgram(std::move(build));
+});
 
-ColorTextureProgram::ColorTextureProgram() {
-	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
-	program = gl_compile_program(
+GLProgramBuild ColorTextureProgram::submit() {
+	//Start compiling vertex and fragment shaders using the convenient 'gl_submit_program' helper function:
+	// (the constructor waits for the result)
+	return gl_submit_program(
 		//vertex shader:
 		"#version 330\n"
 		// "uniform mat4 CLIP_FROM_OBJECT;\n"
@@ -37,6 +40,11 @@ ColorTextureProgram::ColorTextureProgram() {
 	);
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
+}
+
+ColorTextureProgram::ColorTextureProgram(GLProgramBuild &&build) {
+	//wait for the shaders submitted by submit() to finish compiling:
+	program = gl_await_program(std::move(build));
 
 	//look up the locations of vertex attributes:
 	Position_vec4 = glGetAttribLocation(program, "Position");
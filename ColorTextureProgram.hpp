@@ -1,11 +1,14 @@
 #pragma once
 
 #include "GL.hpp"
+#include "gl_compile_program.hpp"
 #include "Load.hpp"
 
 //Shader program that draws transformed, vertices tinted with vertex colors:
 struct ColorTextureProgram {
-	ColorTextureProgram();
+	//start compiling the shaders (see gl_submit_program); the constructor waits for them to finish:
+	static GLProgramBuild submit();
+	ColorTextureProgram(GLProgramBuild &&build = submit());
 	~ColorTextureProgram();
 
 	GLuint program = 0;
@@ -13,7 +13,6 @@
 
 #pragma comment(lib, "Ws2_32.lib") //link against the winsock2 library
 
-#define MSG_DONTWAIT 0 //on windows, sockets are set to non-blocking with an ioctl
 typedef int ssize_t;
 
 #else
@@ -22,14 +21,17 @@ typedef int ssize_t;
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/ip.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <netdb.h>
+#include <fcntl.h>
 
 #define closesocket close
 
 #endif
 
 #include "Connection.hpp"
+#include "IOUringEngine.hpp"
 
 //------------------------------------------------------
 
@@ -53,6 +55,48 @@ void Connection::close() {
 	}
 }
 
+//---------------------------------
+//Socket setup helpers used by both server and client:
+
+//switch a socket to non-blocking mode (and close-on-exec, where that exists):
+static bool set_nonblocking(Socket s) {
+	#ifdef _WIN32
+	unsigned long one = 1;
+	return 0 == ioctlsocket(s, FIONBIO, &one);
+	#else
+	int flags = fcntl(s, F_GETFL, 0);
+	if (flags < 0 || fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0) return false;
+	fcntl(s, F_SETFD, FD_CLOEXEC);
+	return true;
+	#endif
+}
+
+//did the last socket call fail only because it would have blocked?
+static bool would_block() {
+	#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+	#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+	#endif
+}
+
+//apply TCP_NODELAY and buffer sizes from 'options' to a socket:
+void apply_socket_options(char const *where, Socket s, SocketOptions const &options) {
+	auto set = [&](int level, int name, int value, char const *name_str) {
+		#ifdef _WIN32
+		int ret = setsockopt(s, level, name, reinterpret_cast< const char * >(&value), sizeof(value));
+		#else
+		int ret = setsockopt(s, level, name, &value, sizeof(value));
+		#endif
+		if (ret != 0) {
+			std::cerr << "[" << where << "] note: couldn't set " << name_str << "." << std::endl;
+		}
+	};
+	if (options.no_delay) set(IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+	if (options.send_buffer_size > 0) set(SOL_SOCKET, SO_SNDBUF, options.send_buffer_size, "SO_SNDBUF");
+	if (options.recv_buffer_size > 0) set(SOL_SOCKET, SO_RCVBUF, options.recv_buffer_size, "SO_RCVBUF");
+}
+
 //---------------------------------
 //Polling helper used by both server and client:
 void poll_connections(
@@ -60,7 +104,9 @@ void poll_connections(
 	std::list< Connection > &connections,
 	std::function< void(Connection *, Connection::Event event) > const &on_event,
 	double timeout,
-	Socket listen_socket = InvalidSocket) {
+	Socket listen_socket = InvalidSocket,
+	SocketOptions const &socket_options = SocketOptions(),
+	uint32_t max_accepts = 1) {
 
 	fd_set read_fds, write_fds;
 	FD_ZERO(&read_fds);
@@ -103,22 +149,42 @@ void poll_connections(
 	}
 
 	//add new connections as needed:
+	// (listen_socket is non-blocking, so this drains the pending queue -- up to max_accepts -- in one go)
 	if (listen_socket != InvalidSocket && FD_ISSET(listen_socket, &read_fds)) {
-		Socket got = accept(listen_socket, NULL, NULL);
-		if (got == InvalidSocket) {
-			//oh well.
-		} else {
-			#ifdef _WIN32
-			unsigned long one = 1;
-			if (0 == ioctlsocket(got, FIONBIO, &one)) {
+		for (uint32_t accepted = 0; accepted < max_accepts; ++accepted) {
+			#ifdef __linux__
+			//accept4 hands back a socket that is already non-blocking + close-on-exec:
+			Socket got = accept4(listen_socket, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
 			#else
-			{
+			Socket got = accept(listen_socket, NULL, NULL);
+			if (got != InvalidSocket && !set_nonblocking(got)) {
+				std::cerr << "[" << where << "] couldn't make accepted socket non-blocking; dropping it." << std::endl;
+				::closesocket(got);
+				continue;
+			}
 			#endif
-				connections.emplace_back();
-				connections.back().socket = got;
-				std::cerr << "[" << where << "] client connected on " << connections.back().socket << "." << std::endl; //INFO
-				if (on_event) on_event(&connections.back(), Connection::OnOpen);
+			if (got == InvalidSocket) {
+				#ifndef _WIN32
+				//peer gave up while still in the queue; try the next one:
+				if (errno == ECONNABORTED || errno == EINTR) continue;
+				#endif
+				//queue drained (would_block()) or some other error -- oh well.
+				break;
 			}
+			#ifndef _WIN32
+			if (got >= FD_SETSIZE) {
+				//select() can't watch sockets numbered this high, so refuse rather than overrun the fd_set:
+				std::cerr << "[" << where << "] socket " << got << " is past FD_SETSIZE; refusing connection." << std::endl;
+				::closesocket(got);
+				continue;
+			}
+			#endif
+			apply_socket_options(where, got, socket_options);
+
+			connections.emplace_back();
+			connections.back().socket = got;
+			std::cerr << "[" << where << "] client connected on " << connections.back().socket << "." << std::endl; //INFO
+			if (on_event) on_event(&connections.back(), Connection::OnOpen);
 		}
 	}
 
@@ -131,8 +197,8 @@ void poll_connections(
 		if (c.socket == InvalidSocket || !FD_ISSET(c.socket, &read_fds)) continue;
 
 		while (true) { //read until more data left to read
-			ssize_t ret = recv(c.socket, buffer, BufferSize, MSG_DONTWAIT);
-			if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { // if you haven't received bytes I asked for, just keep going
+			ssize_t ret = recv(c.socket, buffer, BufferSize, 0); //(sockets are non-blocking)
+			if (ret < 0 && would_block()) { // if you haven't received bytes I asked for, just keep going
 				//~no problem~ but no data
 				break;
 			} else if (ret <= 0 || ret > (ssize_t)BufferSize) {
@@ -161,11 +227,11 @@ void poll_connections(
 		if (c.socket == InvalidSocket || c.send_buffer.empty() || !FD_ISSET(c.socket, &write_fds)) continue;
 		
 		#ifdef _WIN32
-		ssize_t ret = send(c.socket, reinterpret_cast< char const * >(c.send_buffer.data()), int(c.send_buffer.size()), MSG_DONTWAIT); // if you can't send all, don't wait
+		ssize_t ret = send(c.socket, reinterpret_cast< char const * >(c.send_buffer.data()), int(c.send_buffer.size()), 0); // if you can't send all, don't wait (sockets are non-blocking)
 		#else
-		ssize_t ret = send(c.socket, reinterpret_cast< char const * >(c.send_buffer.data()), c.send_buffer.size(), MSG_DONTWAIT);
+		ssize_t ret = send(c.socket, reinterpret_cast< char const * >(c.send_buffer.data()), c.send_buffer.size(), 0);
 		#endif 
-		if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		if (ret < 0 && would_block()) {
 			//~no problem~, but don't keep trying
 			break;
 		} else if (ret <= 0 || ret > (ssize_t)c.send_buffer.size()) {
@@ -187,7 +253,7 @@ void poll_connections(
 //---------------------------------
 
 
-Server::Server(std::string const &port) {
+Server::Server(std::string const &port, int backlog, SocketOptions const &socket_options_) : socket_options(socket_options_) {
 
 	#ifdef _WIN32
 	{ //init winsock:
@@ -269,8 +335,18 @@ Server::Server(std::string const &port) {
 		throw std::runtime_error("Failed to bind to port " + port);
 	}
 
+	//buffer sizes set on the listening socket are inherited by accepted sockets
+	// (and SO_RCVBUF needs to be set before the handshake for window scaling to pick it up):
+	apply_socket_options("Server::Server", listen_socket, socket_options);
+
+	//non-blocking, so poll() can accept() until the pending queue is empty:
+	if (!set_nonblocking(listen_socket)) {
+		closesocket(listen_socket);
+		throw std::runtime_error("failed to make listen socket non-blocking");
+	}
+
 	{ //listen on socket
-		int ret = ::listen(listen_socket, 5);
+		int ret = ::listen(listen_socket, backlog);
 		if (ret < 0) {
 			closesocket(listen_socket);
 			throw std::system_error(errno, std::system_category(), "failed to listen on socket");
@@ -278,8 +354,20 @@ Server::Server(std::string const &port) {
 	}
 }
 
+Server::~Server() {
+}
+
 void Server::poll(std::function< void(Connection *, Connection::Event event) > const &on_event, double timeout) {
-	poll_connections("Server::poll", connections, on_event, timeout, listen_socket);
+	if (io_engine == IOEngine::IOUring && !io_uring) {
+		io_uring = IOUringEngine::create("Server::poll", listen_socket, socket_options);
+		if (!io_uring) io_engine = IOEngine::Select;
+	}
+
+	if (io_uring) {
+		io_uring->poll(connections, on_event, timeout);
+	} else {
+		poll_connections("Server::poll", connections, on_event, timeout, listen_socket, socket_options, max_accepts_per_poll);
+	}
 
 	//reap closed clients:
 	for (auto connection = connections.begin(); connection != connections.end(); /*later*/) {
@@ -291,7 +379,7 @@ void Server::poll(std::function< void(Connection *, Connection::Event event) > c
 	}
 }
 
-Client::Client(std::string const &host, std::string const &port) : connections(1), connection(connections.front()) {
+Client::Client(std::string const &host, std::string const &port, SocketOptions const &socket_options) : connections(1), connection(connections.front()) {
 	#ifdef _WIN32
 	{ //init winsock:
 		WSADATA info;
@@ -348,6 +436,13 @@ Client::Client(std::string const &host, std::string const &port) : connections(1
 			}
 			std::cout << "success!" << std::endl;
 
+			//connect() above was blocking; from here on, only non-blocking calls:
+			if (!set_nonblocking(s)) {
+				closesocket(s);
+				throw std::runtime_error("Failed to make connection socket non-blocking.");
+			}
+			apply_socket_options("Client::Client", s, socket_options);
+
 			connection.socket = s;
 			break;
 		}
@@ -361,7 +456,19 @@ Client::Client(std::string const &host, std::string const &port) : connections(1
 }
 
 
+Client::~Client() {
+}
+
 void Client::poll(std::function< void(Connection *, Connection::Event event) > const &on_event, double timeout) {
-	poll_connections("Client::poll", connections, on_event, timeout, InvalidSocket);
+	if (io_engine == IOEngine::IOUring && !io_uring) {
+		io_uring = IOUringEngine::create("Client::poll", InvalidSocket, SocketOptions());
+		if (!io_uring) io_engine = IOEngine::Select;
+	}
+
+	if (io_uring) {
+		io_uring->poll(connections, on_event, timeout);
+	} else {
+		poll_connections("Client::poll", connections, on_event, timeout, InvalidSocket);
+	}
 }
 
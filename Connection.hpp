@@ -64,6 +64,7 @@ int main(int argc, char **argv) {
 #include <list>
 #include <string>
 #include <functional>
+#include <memory>
 #include <cstdint>
 
 //Thin wrapper around a (polling-based) TCP socket connection:
@@ -99,8 +100,32 @@ struct Connection {
 	};
 };
 
+//Per-socket tuning applied to accepted (server) and connected (client) sockets:
+struct SocketOptions {
+	bool no_delay = true; //disable Nagle's algorithm (TCP_NODELAY) so small messages go out right away
+	int send_buffer_size = 0; //SO_SNDBUF in bytes (0 leaves the OS default)
+	int recv_buffer_size = 0; //SO_RCVBUF in bytes (0 leaves the OS default)
+};
+
+//apply TCP_NODELAY and buffer sizes from 'options' to a socket ('where' prefixes any warnings):
+void apply_socket_options(char const *where, Socket s, SocketOptions const &options);
+
+//How poll() waits for and moves socket data:
+enum class IOEngine : uint8_t {
+	Select, //portable select() + recv()/send() calls (default)
+	IOUring, //linux io_uring: all socket work for a poll() goes to the kernel in one submission
+	         // (falls back to Select, with a note on stderr, where io_uring isn't available)
+};
+
+struct IOUringEngine; //(internals; see IOUringEngine.hpp)
+
 struct Server {
-	Server(std::string const &port); //pass the port number to listen on, as a string (servname, really)
+	//pass the port number to listen on, as a string (servname, really):
+	// 'backlog' is the length of the pending-connection queue passed to listen()
+	Server(std::string const &port, int backlog = DefaultBacklog, SocketOptions const &socket_options = SocketOptions());
+
+	//default length of the listen() queue:
+	static constexpr int DefaultBacklog = 128;
 
 	//poll() updates the list of active connections and sends/receives data if possible:
 	// (will wait up to 'timeout' for first event)
@@ -111,11 +136,23 @@ struct Server {
 
 	std::list< Connection > connections;
 	Socket listen_socket = InvalidSocket;
+
+	//applied to every accepted socket:
+	SocketOptions socket_options;
+	//at most this many pending connections are accepted per poll():
+	// (so a connect storm can't starve traffic on existing connections)
+	uint32_t max_accepts_per_poll = 64;
+
+	//set before the first poll() to pick an I/O engine:
+	IOEngine io_engine = IOEngine::Select;
+	std::unique_ptr< IOUringEngine > io_uring; //created by the first poll() if io_engine is IOUring
+
+	~Server();
 };
 
 
 struct Client {
-	Client(std::string const &host, std::string const &port);
+	Client(std::string const &host, std::string const &port, SocketOptions const &socket_options = SocketOptions());
 
 	//poll() checks the status of the active connection and sends/receives data if possible:
 	// (will wait up to 'timeout' for first event)
@@ -126,4 +163,10 @@ struct Client {
 
 	std::list< Connection > connections; //will only ever contain exactly one connection
 	Connection &connection; //reference to the only connection in the connections list
+
+	//set before the first poll() to pick an I/O engine:
+	IOEngine io_engine = IOEngine::Select;
+	std::unique_ptr< IOUringEngine > io_uring; //created by the first poll() if io_engine is IOUring
+
+	~Client();
 };
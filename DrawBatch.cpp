@@ -0,0 +1,118 @@
+#include "DrawBatch.hpp"
+#include "ColorProgram.hpp"
+#include "SDFTextProgram.hpp"
+#include "StreamRing.hpp"
+
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+//All DrawBatch instances stream their vertices through one ring:
+// (ranges start at whole vertices, so draws can address them with 'first')
+static StreamRing &vertex_ring() {
+	static StreamRing ring(GL_ARRAY_BUFFER, sizeof(DrawBatch::Vertex));
+	return ring;
+}
+
+static GLuint vertex_buffer_for_color_program = 0;
+static GLuint vertex_buffer_for_sdf_text_program = 0;
+
+static Load< void > setup_buffers(LoadTagDefault, [](){
+	//(the ring keeps its buffer name when it grows or orphans, so vaos can refer to it)
+	vertex_ring().create();
+
+	//both programs read the same vertices (color_program just skips TexCoord):
+	auto make_vao = [](GLuint Position_vec4, GLuint Color_vec4, GLuint TexCoord_vec2) {
+		GLuint vao = 0;
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_ring().buffer);
+
+		glVertexAttribPointer(Position_vec4, 4, GL_FLOAT, GL_FALSE, sizeof(DrawBatch::Vertex), (GLbyte *)0 + offsetof(DrawBatch::Vertex, Position));
+		glEnableVertexAttribArray(Position_vec4);
+
+		glVertexAttribPointer(Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DrawBatch::Vertex), (GLbyte *)0 + offsetof(DrawBatch::Vertex, Color));
+		glEnableVertexAttribArray(Color_vec4);
+
+		if (TexCoord_vec2 != -1U) {
+			glVertexAttribPointer(TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(DrawBatch::Vertex), (GLbyte *)0 + offsetof(DrawBatch::Vertex, TexCoord));
+			glEnableVertexAttribArray(TexCoord_vec2);
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		return vao;
+	};
+	vertex_buffer_for_color_program = make_vao(color_program->Position_vec4, color_program->Color_vec4, -1U);
+	vertex_buffer_for_sdf_text_program = make_vao(sdf_text_program->Position_vec4, sdf_text_program->Color_vec4, sdf_text_program->TexCoord_vec2);
+
+	GL_ERRORS(); //PARANOIA: make sure nothing strange happened during setup
+});
+
+DrawBatch::~DrawBatch() {
+	GLsizeiptr bytes = 0;
+	for (auto const &group : groups) {
+		bytes += GLsizeiptr(group.vertices.size() * sizeof(Vertex));
+	}
+	if (bytes == 0) return;
+
+	std::stable_sort(groups.begin(), groups.end(), [](Group const &a, Group const &b) {
+		if (a.kind != b.kind) return a.kind < b.kind;
+		return a.tex < b.tex;
+	});
+
+	//---- upload every group's vertices into the next free part of the buffer ----
+	StreamRing &ring = vertex_ring();
+	GLsizeiptr offset = 0;
+	char *mapped = ring.map(bytes, &offset);
+	for (auto const &group : groups) {
+		GLsizeiptr size = GLsizeiptr(group.vertices.size() * sizeof(Vertex));
+		std::memcpy(mapped, group.vertices.data(), size);
+		mapped += size;
+	}
+	ring.unmap();
+
+	//---- draw each group with one call ----
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendEquation(GL_FUNC_ADD);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glm::mat4 identity = glm::mat4(1.0f); //(vertices are already in clip space)
+	GLint first = GLint(offset / sizeof(Vertex));
+	for (size_t g = 0; g < groups.size(); ++g) {
+		Group const &group = groups[g];
+		if (g == 0 || groups[g-1].kind != group.kind) {
+			if (group.kind == Lines) {
+				glUseProgram(color_program->program);
+				glUniformMatrix4fv(color_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(identity));
+				glBindVertexArray(vertex_buffer_for_color_program);
+			} else { assert(group.kind == SDFText);
+				glUseProgram(sdf_text_program->program);
+				glUniformMatrix4fv(sdf_text_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(identity));
+				glBindVertexArray(vertex_buffer_for_sdf_text_program);
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, group.tex);
+
+		glDrawArrays(group.kind == Lines ? GL_LINES : GL_TRIANGLES, first, GLsizei(group.vertices.size()));
+		first += GLint(group.vertices.size());
+	}
+
+	//(the ring range can be reused once the GPU gets past these draws)
+	ring.fence();
+
+	//turn off blending:
+	glDisable(GL_BLEND);
+	//...leave depth test off, since code that wants it will turn it back on
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+ * Helper for drawing a frame's 2D overlay -- UI text and (debug) lines --
+ * in as few draw calls as possible.
+ *
+ * Make one DrawBatch per frame, hand it to whatever draws the overlay, and
+ * everything is drawn when it goes out of scope:
+ *
+ *   {
+ *     DrawBatch batch;
+ *     {
+ *       DrawLines lines(world_to_clip, &batch);
+ *       lines.draw(a, b);
+ *     }
+ *     some_text.draw_text_mesh(batch);
+ *   } //<-- one upload, one draw call per group
+ *
+ * Vertices are grouped by how they are drawn (lines, or text from a given
+ * texture); groups are drawn sorted by kind then texture (so lines end up
+ * under text), and within a group in the order they were added.
+ * Positions are in clip space, so nothing needs its own transform uniform.
+ *
+ * Overlay draws happen with depth testing off and 'over' blending on.
+ */
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+struct DrawBatch {
+	DrawBatch() = default;
+	//Finish drawing (push all groups to the GPU and draw them):
+	~DrawBatch();
+
+	DrawBatch(DrawBatch const &) = delete;
+	DrawBatch &operator=(DrawBatch const &) = delete;
+
+	struct Vertex {
+		glm::vec4 Position; //clip space
+		glm::u8vec4 Color;
+		glm::vec2 TexCoord; //(ignored for lines)
+	};
+
+	//how a group's vertices are drawn (also the order groups are drawn in):
+	enum Kind : uint8_t {
+		Lines, //GL_LINES with ColorProgram
+		SDFText, //GL_TRIANGLES with SDFTextProgram (see GlyphAtlas::SDF)
+	};
+
+	//vertices for a kind + texture; append to this:
+	std::vector< Vertex > &vertices(Kind kind, GLuint tex = 0) {
+		//(only a handful of groups per frame, so a linear search is fine)
+		for (auto &group : groups) {
+			if (group.kind == kind && group.tex == tex) return group.vertices;
+		}
+		groups.emplace_back(Group{ kind, tex, {} });
+		return groups.back().vertices;
+	}
+
+	struct Group {
+		Kind kind;
+		GLuint tex;
+		std::vector< Vertex > vertices;
+	};
+	std::vector< Group > groups;
+};
@@ -63,7 +63,7 @@ static Load< void > setup_buffers(LoadTagDefault, [](){
 });
 
 
-DrawLines::DrawLines(glm::mat4 const &world_to_clip_) : world_to_clip(world_to_clip_) {
+DrawLines::DrawLines(glm::mat4 const &world_to_clip_, DrawBatch *batch_) : world_to_clip(world_to_clip_), batch(batch_) {
 }
 
 void DrawLines::draw(glm::vec3 const &a, glm::vec3 const &b, glm::u8vec4 const &color) {
@@ -135,6 +135,16 @@ void DrawLines::draw_text(std::string const &text, glm::vec3 const &anchor_in, g
 DrawLines::~DrawLines() {
 	if (attribs.empty()) return;
 
+	if (batch) {
+		//batched lines are drawn later, alongside everything else, so go to clip space now:
+		std::vector< DrawBatch::Vertex > &out = batch->vertices(DrawBatch::Lines);
+		out.reserve(out.size() + attribs.size());
+		for (auto const &v : attribs) {
+			out.emplace_back(DrawBatch::Vertex{ world_to_clip * glm::vec4(v.Position, 1.0f), v.Color, glm::vec2(0.0f) });
+		}
+		return;
+	}
+
 	//based on DrawSprites.cpp :
 
 	//upload vertices to vertex_buffer:
@@ -6,17 +6,22 @@
  *
  * Similar usage pattern to DrawSprites.
  *
+ * If given a DrawBatch, lines are added to it (and drawn along with the rest
+ * of the frame's overlay) instead of being drawn by the destructor.
+ *
  */
 
 
+#include "DrawBatch.hpp"
+
 #include <glm/glm.hpp>
 
 #include <string>
 #include <vector>
 
 struct DrawLines {
-	//Start drawing; will remember world_to_clip matrix:
-	DrawLines(glm::mat4 const &world_to_clip);
+	//Start drawing; will remember world_to_clip matrix (and batch, if any):
+	DrawLines(glm::mat4 const &world_to_clip, DrawBatch *batch = nullptr);
 
 	//draw a single line from a to b (in world space):
 	void draw(glm::vec3 const &a, glm::vec3 const &b, glm::u8vec4 const &color = glm::u8vec4(0xff));
@@ -33,11 +38,12 @@ struct DrawLines {
 		glm::u8vec4 const &color = glm::u8vec4(0xff),
 		glm::vec3 *anchor_out = nullptr);
 
-	//Finish drawing (push attribs to GPU):
+	//Finish drawing (push attribs to GPU, or to batch):
 	~DrawLines();
 
 
 	glm::mat4 world_to_clip;
+	DrawBatch *batch = nullptr;
 	struct Vertex {
 		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_) : Position(Position_), Color(Color_) { }
 		glm::vec3 Position;
@@ -0,0 +1,102 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_SSE 1
+#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum(glm::mat4 const &clip_from_world) {
+	//A point is inside when -w <= x,y,z <= w in clip space; each of those six
+	// inequalities is a plane in world space made from rows of the matrix.
+	// (Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix")
+	auto row = [&](int r) {
+		return glm::vec4(clip_from_world[0][r], clip_from_world[1][r], clip_from_world[2][r], clip_from_world[3][r]);
+	};
+	glm::vec4 planes[PlaneCount] = {
+		row(3) + row(0), //left
+		row(3) - row(0), //right
+		row(3) + row(1), //bottom
+		row(3) - row(1), //top
+		row(3) + row(2), //near
+		row(3) - row(2), //far (all-inside for an infinite perspective matrix)
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), //padding
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), //padding
+	};
+	for (uint32_t i = 0; i < PlaneCount; ++i) {
+		a[i] = planes[i].x;
+		b[i] = planes[i].y;
+		c[i] = planes[i].z;
+		d[i] = planes[i].w;
+	}
+}
+
+bool Frustum::overlaps(glm::vec3 const &center, glm::vec3 const &radius) const {
+	//the box is outside if, for some plane, even its corner furthest along the plane normal is behind it:
+	// i.e., dot(n, center) + d + dot(abs(n), radius) < 0
+#ifdef FRUSTUM_SSE
+	__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	__m128 rx = _mm_set1_ps(radius.x), ry = _mm_set1_ps(radius.y), rz = _mm_set1_ps(radius.z);
+	__m128 sign = _mm_set1_ps(-0.0f);
+	for (uint32_t i = 0; i < PlaneCount; i += 4) {
+		__m128 pa = _mm_load_ps(a + i), pb = _mm_load_ps(b + i), pc = _mm_load_ps(c + i), pd = _mm_load_ps(d + i);
+		__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa, cx), _mm_mul_ps(pb, cy)), _mm_add_ps(_mm_mul_ps(pc, cz), pd));
+		__m128 reach = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_andnot_ps(sign, pa), rx),
+			_mm_mul_ps(_mm_andnot_ps(sign, pb), ry)),
+			_mm_mul_ps(_mm_andnot_ps(sign, pc), rz));
+		if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, reach), _mm_setzero_ps()))) return false;
+	}
+	return true;
+#else
+	for (uint32_t i = 0; i < PlaneCount; ++i) {
+		float dist = a[i] * center.x + b[i] * center.y + c[i] * center.z + d[i];
+		float reach = std::abs(a[i]) * radius.x + std::abs(b[i]) * radius.y + std::abs(c[i]) * radius.z;
+		if (dist + reach < 0.0f) return false;
+	}
+	return true;
+#endif
+}
+
+bool Frustum::contains(glm::vec3 const &center, glm::vec3 const &radius) const {
+	//the box is inside if, for every plane, even its corner furthest against the plane normal is in front of it:
+	// i.e., dot(n, center) + d - dot(abs(n), radius) >= 0
+#ifdef FRUSTUM_SSE
+	__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	__m128 rx = _mm_set1_ps(radius.x), ry = _mm_set1_ps(radius.y), rz = _mm_set1_ps(radius.z);
+	__m128 sign = _mm_set1_ps(-0.0f);
+	for (uint32_t i = 0; i < PlaneCount; i += 4) {
+		__m128 pa = _mm_load_ps(a + i), pb = _mm_load_ps(b + i), pc = _mm_load_ps(c + i), pd = _mm_load_ps(d + i);
+		__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa, cx), _mm_mul_ps(pb, cy)), _mm_add_ps(_mm_mul_ps(pc, cz), pd));
+		__m128 reach = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_andnot_ps(sign, pa), rx),
+			_mm_mul_ps(_mm_andnot_ps(sign, pb), ry)),
+			_mm_mul_ps(_mm_andnot_ps(sign, pc), rz));
+		if (_mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, reach), _mm_setzero_ps()))) return false;
+	}
+	return true;
+#else
+	for (uint32_t i = 0; i < PlaneCount; ++i) {
+		float dist = a[i] * center.x + b[i] * center.y + c[i] * center.z + d[i];
+		float reach = std::abs(a[i]) * radius.x + std::abs(b[i]) * radius.y + std::abs(c[i]) * radius.z;
+		if (dist - reach < 0.0f) return false;
+	}
+	return true;
+#endif
+}
+
+void Frustum::world_box(glm::mat4x3 const &world_from_local, glm::vec3 const &min, glm::vec3 const &max, glm::vec3 *center_, glm::vec3 *radius_) {
+	glm::vec3 local_center = 0.5f * (max + min);
+	glm::vec3 local_radius = 0.5f * (max - min);
+
+	//center transforms as a point; radius by the absolute value of the linear part (Arvo, "Transforming Axis-Aligned Bounding Boxes"):
+	glm::vec3 &center = *center_;
+	glm::vec3 &radius = *radius_;
+	center = world_from_local[3];
+	radius = glm::vec3(0.0f);
+	for (uint32_t c = 0; c < 3; ++c) {
+		center += world_from_local[c] * local_center[c];
+		radius += glm::abs(world_from_local[c]) * local_radius[c];
+	}
+}
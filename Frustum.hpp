@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * A Frustum holds the clipping planes of a clip_from_world matrix, for
+ *  quickly rejecting bounding boxes that can't be seen.
+ *
+ * Boxes are tested against four planes at once with SSE (when available).
+ *
+ * Example:
+ *   Frustum frustum(camera.make_projection() * glm::mat4(camera_from_world));
+ *   if (!frustum.overlaps(center, radius)) { ...box is not visible... }
+ */
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+struct Frustum {
+	//extract planes from a clip_from_world matrix:
+	Frustum(glm::mat4 const &clip_from_world);
+
+	//is the box with world-space 'center' and half-size 'radius' (at least partly) inside?
+	// (conservative: boxes near frustum corners may be reported as inside)
+	bool overlaps(glm::vec3 const &center, glm::vec3 const &radius) const;
+	//is the box entirely inside?
+	bool contains(glm::vec3 const &center, glm::vec3 const &radius) const;
+
+	//world-space center/radius of the box [min,max] in an object with the given world_from_local:
+	static void world_box(glm::mat4x3 const &world_from_local, glm::vec3 const &min, glm::vec3 const &max, glm::vec3 *center, glm::vec3 *radius);
+
+	//planes a*x + b*y + c*z + d >= 0 (inside), stored structure-of-arrays:
+	// (planes 6 and 7 are padding that everything is inside of)
+	enum : uint32_t { PlaneCount = 8 };
+	alignas(16) float a[PlaneCount];
+	alignas(16) float b[PlaneCount];
+	alignas(16) float c[PlaneCount];
+	alignas(16) float d[PlaneCount];
+};
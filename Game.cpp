@@ -1,6 +1,7 @@
 #include "Game.hpp"
 
 #include "Connection.hpp"
+#include "compress_lz4.hpp"
 
 #include <stdexcept>
 #include <iostream>
@@ -14,7 +15,7 @@ void Player::Controls::send_controls_message(Connection *connection_) const {
 	assert(connection_);
 	auto &connection = *connection_;
 
-	uint32_t size = 5;
+	uint32_t size = PayloadSize;
 	connection.send(Message::C2S_Controls);
 	connection.send(uint8_t(size));
 	connection.send(uint8_t(size >> 8));
@@ -35,22 +36,8 @@ void Player::Controls::send_controls_message(Connection *connection_) const {
 }
 
 
-bool Player::Controls::recv_controls_message(Connection *connection_) {
-	assert(connection_);
-	auto &connection = *connection_;
-
-	auto &recv_buffer = connection.recv_buffer;
-
-	//expecting [type, size_low0, size_mid8, size_high8]:
-	if (recv_buffer.size() < 4) return false;
-	if (recv_buffer[0] != uint8_t(Message::C2S_Controls)) return false;
-	uint32_t size = (uint32_t(recv_buffer[3]) << 16)
-	              | (uint32_t(recv_buffer[2]) << 8)
-	              |  uint32_t(recv_buffer[1]);
-	if (size != 5) throw std::runtime_error("Controls message with size " + std::to_string(size) + " != 5!");
-	
-	//expecting complete message:
-	if (recv_buffer.size() < 4 + size) return false;
+void Player::Controls::recv_controls_payload(std::span< uint8_t const > payload) {
+	if (payload.size() != PayloadSize) throw std::runtime_error("Controls message with size " + std::to_string(payload.size()) + " != " + std::to_string(PayloadSize) + "!");
 
 	auto recv_button = [](uint8_t byte, Button *button) {
 		button->pressed = (byte & 0x80);
@@ -62,16 +49,11 @@ bool Player::Controls::recv_controls_message(Connection *connection_) {
 		button->downs = uint8_t(d);
 	};
 
-	recv_button(recv_buffer[4+0], &left);
-	recv_button(recv_buffer[4+1], &right);
-	recv_button(recv_buffer[4+2], &up);
-	recv_button(recv_buffer[4+3], &down);
-	recv_button(recv_buffer[4+4], &start);
-
-	//delete message from buffer:
-	recv_buffer.erase(recv_buffer.begin(), recv_buffer.begin() + 4 + size);
-
-	return true;
+	recv_button(payload[0], &left);
+	recv_button(payload[1], &right);
+	recv_button(payload[2], &up);
+	recv_button(payload[3], &down);
+	recv_button(payload[4], &start);
 }
 
 
@@ -485,59 +467,169 @@ void Game::update(float elapsed) {
 // This is called by the server's game, which sends this to each client's PlayMode::game
 void Game::send_state_message(Connection *connection_, Player *connection_player) const {
 	assert(connection_);
-	auto &connection = *connection_;
+	append_state_message(&connection_->send_buffer, connection_player);
+}
+
+void Game::append_state_message(std::vector< uint8_t > *buffer_, Player const *first_player) const {
+	assert(buffer_);
+	auto &buffer = *buffer_;
 
-	connection.send(Message::S2C_State);
+	//append bytes of any plain-old-data value:
+	auto send = [&](auto const &val) {
+		uint8_t const *bytes = reinterpret_cast< uint8_t const * >(&val);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(val));
+	};
+
+	send(Message::S2C_State);
 	//will patch message size in later, for now placeholder bytes:
-	connection.send(uint8_t(0));
-	connection.send(uint8_t(0));
-	connection.send(uint8_t(0));
-	size_t mark = connection.send_buffer.size(); //keep track of this position in the buffer (mark is currently 3)
+	send(uint8_t(0));
+	send(uint8_t(0));
+	send(uint8_t(0));
+	size_t mark = buffer.size(); //keep track of this position in the buffer (mark is currently 3 past the message start)
 
 	//send player info helper:
 	auto send_player = [&](Player const &player) {
-		// connection.send(player.position);
-		// connection.send(player.velocity);
+		// send(player.position);
+		// send(player.velocity);
 		// DEBUG
-		// connection.send(player.color);
+		// send(player.color);
 
-		connection.send(player.playerNumber);
-		connection.send(player.activePlayer);
-		connection.send(player.advantageDirection);
+		send(player.playerNumber);
+		send(player.activePlayer);
+		send(player.advantageDirection);
 
 		// TODO: need 4 bytes to send a float?
-		connection.send(player.penalty);
-		connection.send(player.advantage);
+		send(player.penalty);
+		send(player.advantage);
 
 		//NOTE: can't just 'send(name)' because player.name is not plain-old-data type.
 		//effectively: truncates player name to 255 chars
 		uint8_t len = uint8_t(std::min< size_t >(255, player.name.size()));
-		connection.send(len);
-		connection.send_buffer.insert(connection.send_buffer.end(), player.name.begin(), player.name.begin() + len);
+		send(len);
+		buffer.insert(buffer.end(), player.name.begin(), player.name.begin() + len);
 
 		// no need to send player inputs, those get refreshed at the beginning of the game state update
 	};
 
 	//player count:
-	connection.send(uint8_t(players.size()));
-	if (connection_player) send_player(*connection_player); // this is where we see the server send the current player first
+	send(uint8_t(players.size()));
+	if (first_player) send_player(*first_player); // this is where we see the server send the current player first
 	for (auto const &player : players) {
-		if (&player == connection_player) continue;
+		if (&player == first_player) continue;
 		send_player(player);
 	}
-	connection.send(Player::activePlayerCount);
+	send(Player::activePlayerCount);
 
-	connection.send(progress);
-	connection.send(triggerDirection);
-	connection.send(matchState);
-	connection.send(tugClockTimer);
+	send(progress);
+	send(triggerDirection);
+	send(matchState);
+	send(tugClockTimer); //(keep last: server.cpp leaves it out when checking if spectator state changed)
 
 	//compute the message size and patch into the message header:
-	uint32_t size = uint32_t(connection.send_buffer.size() - mark);
+	uint32_t size = uint32_t(buffer.size() - mark);
+
+	buffer[mark-3] = uint8_t(size); // 0: size (lops off leading beyond 8)
+	buffer[mark-2] = uint8_t(size >> 8); // 1: size (lops off leading 16, and last 8)
+	buffer[mark-1] = uint8_t(size >> 16); // 2: size (lops of leading beyond 24, and last 16)
+}
+
+void Game::append_compressed_state_message(std::vector< uint8_t > *buffer_, Player const *first_player) const {
+	assert(buffer_);
+	auto &buffer = *buffer_;
+
+	std::vector< uint8_t > raw;
+	append_state_message(&raw, first_player);
+	std::span< uint8_t const > raw_payload = std::span< uint8_t const >(raw).subspan(4);
+
+	size_t start = buffer.size();
+	buffer.emplace_back(uint8_t(Message::S2C_StateCompressed));
+	//will patch message size in later, for now placeholder bytes:
+	buffer.emplace_back(uint8_t(0));
+	buffer.emplace_back(uint8_t(0));
+	buffer.emplace_back(uint8_t(0));
+	size_t mark = buffer.size();
+
+	uint32_t raw_size = uint32_t(raw_payload.size());
+	buffer.insert(buffer.end(), reinterpret_cast< uint8_t const * >(&raw_size), reinterpret_cast< uint8_t const * >(&raw_size) + 4);
+	compress_lz4(raw_payload, state_dictionary(), &buffer);
+
+	if (buffer.size() - start >= raw.size()) {
+		//compression didn't help, so just send uncompressed:
+		buffer.resize(start);
+		buffer.insert(buffer.end(), raw.begin(), raw.end());
+		return;
+	}
+
+	//patch message size into the header:
+	uint32_t size = uint32_t(buffer.size() - mark);
+	buffer[mark-3] = uint8_t(size);
+	buffer[mark-2] = uint8_t(size >> 8);
+	buffer[mark-1] = uint8_t(size >> 16);
+}
+
+std::vector< uint8_t > const &Game::state_dictionary() {
+	static std::vector< uint8_t > dictionary = [](){
+		//payloads of state messages from a sample game with a couple of players, a few, and a crowd:
+		std::vector< uint8_t > ret;
+
+		//NOTE: activePlayerCount is static (and part of the message), so pin it while building:
+		int old_active_player_count = Player::activePlayerCount;
+		Player::activePlayerCount = 2;
+
+		Game sample;
+		for (uint32_t count : {24, 6, 2}) {
+			sample.players.clear();
+			for (uint32_t i = 1; i <= count; ++i) {
+				sample.players.emplace_back();
+				Player &player = sample.players.back();
+				player.name = "Player " + std::to_string(i);
+				player.playerNumber = int(i);
+				player.activePlayer = (i <= 2);
+				player.advantageDirection = (i == 1 ? -1 : (i == 2 ? 1 : 0));
+			}
+			std::vector< uint8_t > message;
+			sample.append_state_message(&message, &sample.players.back());
+			ret.insert(ret.end(), message.begin() + 4, message.end());
+		}
+
+		Player::activePlayerCount = old_active_player_count;
+		return ret;
+	}();
+	return dictionary;
+}
 
-	connection.send_buffer[mark-3] = uint8_t(size); // 0: size (lops off leading beyond 8)
-	connection.send_buffer[mark-2] = uint8_t(size >> 8); // 1: size (lops off leading 16, and last 8)
-	connection.send_buffer[mark-1] = uint8_t(size >> 16); // 2: size (lops of leading beyond 24, and last 16)
+uint32_t Game::state_dictionary_id() {
+	//FNV-1a:
+	uint32_t hash = 0x811c9dc5;
+	for (uint8_t b : state_dictionary()) {
+		hash = (hash ^ b) * 0x01000193;
+	}
+	return hash;
+}
+
+void Game::send_compression_message(Connection *connection_) {
+	assert(connection_);
+	auto &connection = *connection_;
+
+	uint32_t size = 5;
+	connection.send(Message::C2S_Compression);
+	connection.send(uint8_t(size));
+	connection.send(uint8_t(size >> 8));
+	connection.send(uint8_t(size >> 16));
+	connection.send(CompressionLZ4);
+	connection.send(state_dictionary_id());
+}
+
+void Game::send_pause_message(Connection *connection_, bool paused) {
+	assert(connection_);
+	auto &connection = *connection_;
+
+	uint32_t size = 1;
+	connection.send(Message::C2S_Pause);
+	connection.send(uint8_t(size));
+	connection.send(uint8_t(size >> 8));
+	connection.send(uint8_t(size >> 16));
+	connection.send(uint8_t(paused ? 1 : 0));
 }
 
 // Modified Game5 starter code with new Player members
@@ -548,20 +640,43 @@ bool Game::recv_state_message(Connection *connection_) {
 	auto &recv_buffer = connection.recv_buffer;
 
 	if (recv_buffer.size() < 4) return false;
-	if (recv_buffer[0] != uint8_t(Message::S2C_State)) return false;
+	if (recv_buffer[0] != uint8_t(Message::S2C_State) && recv_buffer[0] != uint8_t(Message::S2C_StateCompressed)) return false;
 	uint32_t size = (uint32_t(recv_buffer[3]) << 16)
 	              | (uint32_t(recv_buffer[2]) << 8)
 	              |  uint32_t(recv_buffer[1]);
-	uint32_t at = 0;
 	//expecting complete message:
 	if (recv_buffer.size() < 4 + size) return false;
 
-	//copy bytes from buffer and advance position:
+	std::span< uint8_t const > payload(recv_buffer.data() + 4, size);
+	if (recv_buffer[0] == uint8_t(Message::S2C_StateCompressed)) {
+		//expecting [uncompressed size (4 bytes), lz4 block]:
+		if (size < 4) throw std::runtime_error("Compressed state message too short.");
+		uint32_t raw_size;
+		std::memcpy(&raw_size, payload.data(), 4);
+		if (raw_size > 0xffffff) throw std::runtime_error("Compressed state message claims to be " + std::to_string(raw_size) + " bytes.");
+
+		std::vector< uint8_t > raw;
+		decompress_lz4(payload.subspan(4), state_dictionary(), raw_size, &raw);
+		read_state_payload(raw);
+	} else {
+		read_state_payload(payload);
+	}
+
+	//delete message from buffer:
+	recv_buffer.erase(recv_buffer.begin(), recv_buffer.begin() + 4 + size);
+
+	return true;
+}
+
+void Game::read_state_payload(std::span< uint8_t const > payload) {
+	uint32_t at = 0;
+
+	//copy bytes from payload and advance position:
 	auto read = [&](auto *val) {
-		if (at + sizeof(*val) > size) {
+		if (at + sizeof(*val) > payload.size()) {
 			throw std::runtime_error("Ran out of bytes reading state message.");
 		}
-		std::memcpy(val, &recv_buffer[4 + at], sizeof(*val));
+		std::memcpy(val, &payload[at], sizeof(*val));
 		at += sizeof(*val);
 	};
 
@@ -602,10 +717,5 @@ bool Game::recv_state_message(Connection *connection_) {
 	read((&matchState));
 	read((&tugClockTimer));
 
-	if (at != size) throw std::runtime_error("Trailing data in state message.");
-
-	//delete message from buffer:
-	recv_buffer.erase(recv_buffer.begin(), recv_buffer.begin() + 4 + size);
-
-	return true;
+	if (at != payload.size()) throw std::runtime_error("Trailing data in state message.");
 }
@@ -4,7 +4,9 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include <random>
+#include <span>
 
 struct Connection;
 
@@ -14,7 +16,10 @@ struct Connection;
 
 enum class Message : uint8_t {
 	C2S_Controls = 1, //Greg!
+	C2S_Pause = 'p', //client stopped (1) or resumed (0) showing the game -- e.g., window minimized
+	C2S_Compression = 'c', //client can decompress state messages (sent once, after connecting)
 	S2C_State = 's',
+	S2C_StateCompressed = 'z', //S2C_State payload, compressed (see append_compressed_state_message)
 	//...
 };
 
@@ -32,10 +37,10 @@ struct Player {
 
 		void send_controls_message(Connection *connection) const;
 
-		//returns 'false' if no message or not a controls message,
-		//returns 'true' if read a controls message,
-		//throws on malformed controls message
-		bool recv_controls_message(Connection *connection);
+		//read the payload of a controls message (e.g., as handed over by MessageDispatch),
+		//throws on malformed payload
+		void recv_controls_payload(std::span< uint8_t const > payload);
+		static constexpr uint32_t PayloadSize = 5;
 	} controls;
 
 	//player state (sent from server):
@@ -55,6 +60,11 @@ struct Player {
 	float penalty = 0.0f; // false starts add to penalty
 	bool advantage = false;
 	std::vector<Button*> inputs = {}; // cleared each frame
+
+	// state update subscription (server only, not sent):
+	bool paused = false; // client isn't showing the game, so don't send it state
+	bool needs_state = true; // send state on the next tick whatever the update tier (just joined / unpaused)
+	bool compressed_state = false; // client asked for (and can decompress) S2C_StateCompressed
 };
 
 struct Game {
@@ -150,8 +160,34 @@ struct Game {
 	// (return true if data was read)
 	bool recv_state_message(Connection *connection);
 
+	//read the payload of a state message (uncompressed):
+	void read_state_payload(std::span< uint8_t const > payload);
+
+	//used by client:
+	//ask server to stop (paused = true) or resume sending state
+	static void send_pause_message(Connection *connection, bool paused);
+
+	//used by client:
+	//tell server that state messages may be compressed
+	static void send_compression_message(Connection *connection);
+
 	//used by server:
 	//send game state.
 	//  Will move "connection_player" to the front of the front of the sent list.
 	void send_state_message(Connection *connection, Player *connection_player = nullptr) const;
+
+	//used by server:
+	//append a game state message to 'buffer' (so it can be sent to several connections).
+	//  "first_player" is sent first, as with connection_player above.
+	void append_state_message(std::vector< uint8_t > *buffer, Player const *first_player = nullptr) const;
+
+	//used by server:
+	//as above, but LZ4-compressed against state_dictionary() (as S2C_StateCompressed) if that makes it smaller.
+	void append_compressed_state_message(std::vector< uint8_t > *buffer, Player const *first_player = nullptr) const;
+
+	//dictionary shared by compressed state messages:
+	// it is built from sample state messages, so it matches on client and server as long as they agree on the message layout
+	static std::vector< uint8_t > const &state_dictionary();
+	static uint32_t state_dictionary_id(); //hash of state_dictionary(), used to check that client and server agree
+	inline static constexpr uint8_t CompressionLZ4 = 1; //(the only codec so far)
 };
@@ -0,0 +1,163 @@
+#include "GlyphAtlas.hpp"
+
+#include "gl_errors.hpp"
+
+#include FT_MODULE_H
+
+#include <stdexcept>
+#include <cstring>
+
+GlyphAtlas::GlyphAtlas(glm::uvec2 size_) : size(size_) {
+	if (FT_Error error = FT_Init_FreeType(&library)) {
+		throw std::runtime_error("Failed to initialize FreeType (error " + std::to_string(error) + ").");
+	}
+	//(FT_RENDER_MODE_SDF uses 'sdf' for outline glyphs and 'bsdf' for bitmap glyphs)
+	for (char const *module : {"sdf", "bsdf"}) {
+		FT_UInt spread = SDFSpread;
+		FT_Property_Set(library, module, "spread", &spread);
+	}
+	hb_buffer = hb_buffer_create();
+
+	//start with an empty (transparent) texture; glyphs are filled in as they are used:
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	std::vector< uint8_t > zeros(size.x * size.y, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size.x, size.y, 0, GL_RED, GL_UNSIGNED_BYTE, zeros.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	//(no mipmaps: text is drawn at about the size it was rasterized, and mips would blur glyphs into their neighbours)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GL_ERRORS();
+}
+
+GlyphAtlas::~GlyphAtlas() {
+	glDeleteTextures(1, &tex);
+	tex = 0;
+	for (auto &font : fonts) {
+		hb_font_destroy(font->hb_font);
+		FT_Done_Face(font->face);
+	}
+	fonts.clear();
+	hb_buffer_destroy(hb_buffer);
+	FT_Done_FreeType(library);
+}
+
+GlyphAtlas &GlyphAtlas::get() {
+	//(never destroyed, since the GL context is gone by the time static destructors run)
+	static GlyphAtlas *atlas = new GlyphAtlas();
+	return *atlas;
+}
+
+GlyphAtlas::Font const &GlyphAtlas::font(std::string const &file, uint32_t pixel_size, Rendering rendering) {
+	for (auto const &font : fonts) {
+		if (font->file == file && font->pixel_size == pixel_size && font->rendering == rendering) return *font;
+	}
+
+	auto font = std::make_unique< Font >();
+	font->file = file;
+	font->pixel_size = pixel_size;
+	font->rendering = rendering;
+	font->padding = (rendering == SDF ? SDFSpread : 0);
+	font->data = std::make_unique< MappedFile >(file);
+	if (FT_Error error = FT_New_Memory_Face(library, reinterpret_cast< FT_Byte const * >(font->data->data), FT_Long(font->data->size), 0, &font->face)) {
+		throw std::runtime_error("Failed to load font '" + file + "' (FreeType error " + std::to_string(error) + ").");
+	}
+	if (FT_Error error = FT_Set_Pixel_Sizes(font->face, 0, pixel_size)) {
+		FT_Done_Face(font->face);
+		throw std::runtime_error("Failed to set font '" + file + "' to " + std::to_string(pixel_size) + "px (FreeType error " + std::to_string(error) + ").");
+	}
+	font->hb_font = hb_ft_font_create(font->face, nullptr);
+
+	fonts.emplace_back(std::move(font));
+	return *fonts.back();
+}
+
+GlyphAtlas::Glyph const &GlyphAtlas::glyph(Font const &font, uint32_t index) {
+	auto f = glyphs.find(GlyphKey{&font, index});
+	if (f != glyphs.end()) return f->second;
+
+	FT_Error error = FT_Load_Glyph(font.face, index, (font.rendering == SDF ? FT_LOAD_DEFAULT : FT_LOAD_RENDER));
+	if (!error && font.rendering == SDF) error = FT_Render_Glyph(font.face->glyph, FT_RENDER_MODE_SDF);
+	if (error) {
+		throw std::runtime_error("Failed to render glyph " + std::to_string(index) + " of '" + font.file + "' (FreeType error " + std::to_string(error) + ").");
+	}
+	FT_GlyphSlot slot = font.face->glyph;
+	FT_Bitmap const &bitmap = slot->bitmap;
+
+	Glyph glyph;
+	glyph.bearing = glm::ivec2(slot->bitmap_left, slot->bitmap_top);
+
+	//find a spot on a shelf (with a pixel of padding all around):
+	glm::uvec2 padded(bitmap.width + 2, bitmap.rows + 2);
+	if (shelf.x + padded.x > size.x) { //start a new shelf:
+		shelf = glm::uvec2(0, shelf.y + shelf_height);
+		shelf_height = 0;
+	}
+	if (padded.x > size.x || shelf.y + padded.y > size.y) {
+		throw std::runtime_error("Glyph atlas (" + std::to_string(size.x) + "x" + std::to_string(size.y) + ") is full.");
+	}
+	glyph.min = glm::ivec2(shelf) + glm::ivec2(1);
+	glyph.max = glyph.min + glm::ivec2(bitmap.width, bitmap.rows);
+	shelf.x += padded.x;
+	shelf_height = std::max(shelf_height, padded.y);
+
+	//upload (rows are copied out since FreeType's pitch may include padding, or be negative for bottom-up bitmaps):
+	if (bitmap.width > 0 && bitmap.rows > 0) {
+		std::vector< uint8_t > coverage(bitmap.width * bitmap.rows);
+		for (uint32_t row = 0; row < bitmap.rows; ++row) {
+			uint8_t const *src = (bitmap.pitch >= 0
+				? bitmap.buffer + row * bitmap.pitch
+				: bitmap.buffer + (bitmap.rows - 1 - row) * -bitmap.pitch);
+			std::memcpy(coverage.data() + row * bitmap.width, src, bitmap.width);
+		}
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, glyph.min.x, glyph.min.y, bitmap.width, bitmap.rows, GL_RED, GL_UNSIGNED_BYTE, coverage.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glyphs_uploaded += 1;
+	}
+
+	return glyphs.emplace(GlyphKey{&font, index}, glyph).first->second;
+}
+
+GlyphAtlas::Shaped const &GlyphAtlas::shape(Font const &font, std::string const &text) {
+	Font const *font_ptr = &font;
+	std::string key(reinterpret_cast< char const * >(&font_ptr), sizeof(font_ptr));
+	key += text;
+	auto f = shaped.find(key);
+	if (f != shaped.end()) return f->second;
+
+	//(don't let a stream of one-off strings grow the cache forever)
+	if (shaped.size() >= 1024) shaped.clear();
+
+	hb_buffer_reset(hb_buffer);
+	hb_buffer_add_utf8(hb_buffer, text.data(), int(text.size()), 0, int(text.size()));
+	hb_buffer_guess_segment_properties(hb_buffer);
+	hb_shape(font.hb_font, hb_buffer, nullptr, 0);
+
+	unsigned int count = 0;
+	hb_glyph_info_t const *info = hb_buffer_get_glyph_infos(hb_buffer, &count);
+	hb_glyph_position_t const *pos = hb_buffer_get_glyph_positions(hb_buffer, nullptr);
+
+	//(HarfBuzz positions are in 26.6 fixed point when the font comes from hb_ft_font_create)
+	Shaped result;
+	result.glyphs.reserve(count);
+	glm::ivec2 pen(0);
+	for (unsigned int i = 0; i < count; ++i) {
+		result.glyphs.emplace_back(Shaped::Placed{
+			info[i].codepoint, //(after shaping, 'codepoint' holds the glyph index)
+			glm::vec2(pen.x + pos[i].x_offset, pen.y + pos[i].y_offset) / 64.0f
+		});
+		pen += glm::ivec2(pos[i].x_advance, pos[i].y_advance);
+	}
+	result.advance = pen.x / 64.0f;
+	strings_shaped += 1;
+
+	return shaped.emplace(key, std::move(result)).first->second;
+}
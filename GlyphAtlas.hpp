@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+ * A GlyphAtlas keeps every glyph any text has used, each rasterized once,
+ *  packed into one shared (single-channel) texture, along with the shaped
+ *  (HarfBuzz) layout of recently-used strings.
+ *
+ * Drawing a string that has been seen before -- e.g., a countdown that
+ *  cycles through the same digits -- is then just a matter of writing one
+ *  quad per glyph into a vertex buffer; nothing is rasterized or uploaded.
+ *
+ * Fonts opened as SDF store each glyph as a signed distance field instead
+ *  of coverage (128 on the outline, more inside, less outside; see
+ *  SDFTextProgram.hpp), padded by SDFSpread pixels all around. One small
+ *  SDF rasterization then draws crisply at any scale or rotation.
+ *
+ * Glyphs are packed in shelves (rows of glyphs, each as tall as the tallest
+ *  glyph on it) with a pixel of padding so linear filtering doesn't bleed
+ *  between neighbours. If the atlas fills up, glyph() throws.
+ *
+ * Example:
+ *   GlyphAtlas &atlas = GlyphAtlas::get();
+ *   GlyphAtlas::Font const &font = atlas.font(data_path("HammersmithOne-Regular.ttf"), 36);
+ *   for (auto const &g : atlas.shape(font, "Hello").glyphs) {
+ *       GlyphAtlas::Glyph const &glyph = atlas.glyph(font, g.index);
+ *       ...make a quad at g.pen + glyph.bearing using glyph.min / glyph.max...
+ *   }
+ *   glBindTexture(GL_TEXTURE_2D, atlas.tex);
+ */
+
+#include "GL.hpp"
+#include "MappedFile.hpp"
+
+#include <glm/glm.hpp>
+
+#include <hb.h>
+#include <hb-ft.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+struct GlyphAtlas {
+	GlyphAtlas(glm::uvec2 size = glm::uvec2(1024, 1024));
+	~GlyphAtlas();
+
+	GlyphAtlas(GlyphAtlas const &) = delete;
+	GlyphAtlas &operator=(GlyphAtlas const &) = delete;
+
+	//the atlas shared by all text (made on first use; needs a GL context):
+	static GlyphAtlas &get();
+
+	//how a font's glyphs are stored in the atlas:
+	enum Rendering : uint8_t {
+		Coverage, //antialiased coverage, for drawing at pixel_size
+		SDF, //signed distance field, for drawing at any size
+	};
+	//distance (in pixels at the font's pixel_size) covered by SDF glyphs' falloff;
+	// SDF glyph bitmaps include this much padding on every side:
+	static constexpr uint32_t SDFSpread = 6;
+
+	//a font file at a pixel size:
+	struct Font {
+		std::string file;
+		uint32_t pixel_size = 0;
+		Rendering rendering = Coverage;
+		uint32_t padding = 0; //(SDFSpread for SDF fonts)
+		std::unique_ptr< MappedFile > data; //(FreeType reads the face from here, so it may come from the asset pack)
+		FT_Face face = nullptr;
+		hb_font_t *hb_font = nullptr;
+	};
+	//opens the font the first time it is asked for; throws if it can't be loaded:
+	Font const &font(std::string const &file, uint32_t pixel_size, Rendering rendering = Coverage);
+
+	//a rasterized glyph (including any padding the font has):
+	struct Glyph {
+		glm::ivec2 min = glm::ivec2(0), max = glm::ivec2(0); //texels covered in the atlas ([min,max), y down)
+		glm::ivec2 bearing = glm::ivec2(0); //offset from pen position to the bitmap's top left corner (y up)
+	};
+	//rasterizes + uploads the glyph the first time it is asked for:
+	Glyph const &glyph(Font const &font, uint32_t index);
+
+	//a shaped string:
+	struct Shaped {
+		struct Placed {
+			uint32_t index; //glyph index in the font
+			glm::vec2 pen; //position (pixels, y up) relative to the start of the string's baseline
+		};
+		std::vector< Placed > glyphs;
+		float advance = 0.0f; //where the pen ends up
+	};
+	//shapes (and caches) a utf8 string:
+	// (the result may be dropped from the cache by later calls, so copy it if you need to keep it)
+	Shaped const &shape(Font const &font, std::string const &text);
+
+	GLuint tex = 0; //GL_R8 coverage or distance (depending on the font)
+	glm::uvec2 size;
+
+	//stats, to check that steady-state text isn't doing any work:
+	uint32_t glyphs_uploaded = 0;
+	uint32_t strings_shaped = 0;
+
+	//internals:
+	FT_Library library = nullptr;
+	hb_buffer_t *hb_buffer = nullptr;
+	std::vector< std::unique_ptr< Font > > fonts;
+	struct GlyphKey {
+		Font const *font;
+		uint32_t index;
+		bool operator==(GlyphKey const &) const = default;
+	};
+	struct GlyphKeyHash {
+		size_t operator()(GlyphKey const &key) const {
+			return std::hash< void const * >()(key.font) ^ (std::hash< uint32_t >()(key.index) * 0x9e3779b97f4a7c15ULL);
+		}
+	};
+	std::unordered_map< GlyphKey, Glyph, GlyphKeyHash > glyphs;
+	std::unordered_map< std::string, Shaped > shaped; //keyed by font address + text
+	glm::uvec2 shelf = glm::uvec2(0); //where the next glyph goes on the current shelf
+	uint32_t shelf_height = 0;
+};
@@ -0,0 +1,584 @@
+#include "IOUringEngine.hpp"
+#include "Connection.hpp"
+
+#include <iostream>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+//multishot recv (the newest feature used here) is what this engine is built around:
+#if defined(__linux__) && defined(IORING_RECV_MULTISHOT)
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <unordered_map>
+#include <vector>
+#include <stdexcept>
+#include <cassert>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+
+//NOTE: liburing isn't part of nest-libs, so this talks to the kernel through the raw system calls.
+// see: https://man7.org/linux/man-pages/man7/io_uring.7.html
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params *params) {
+	return int(syscall(__NR_io_uring_setup, entries, params));
+}
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void const *arg, size_t arg_size) {
+	return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+int sys_io_uring_register(int fd, unsigned opcode, void const *arg, unsigned nr_args) {
+	return int(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+//ring heads/tails are shared with the kernel, so reads and writes need ordering:
+template< typename T >
+T load_acquire(T const *at) { return __atomic_load_n(at, __ATOMIC_ACQUIRE); }
+template< typename T >
+void store_release(T *at, T value) { __atomic_store_n(at, value, __ATOMIC_RELEASE); }
+
+struct Engine final : IOUringEngine {
+	//sizes:
+	static constexpr uint32_t SubmissionEntries = 256;
+	static constexpr uint32_t CompletionEntries = 4096; //multishot recvs on many connections can produce a lot of completions
+	static constexpr uint32_t RecvBufferSize = 16384;
+	static constexpr uint32_t RecvBufferCount = 128; //(must be a power of two)
+	static constexpr uint16_t RecvBufferGroup = 0;
+
+	//what a submission was for; stored in the low bits of its user_data:
+	enum Op : uint64_t {
+		OpAccept = 0,
+		OpRecv = 1,
+		OpSend = 2,
+		OpHousekeeping = 3, //cancels and buffer handoffs (their completions need no handling)
+	};
+	static uint64_t pack(uint64_t id, Op op) { return (id << 2) | op; }
+
+	Engine(char const *where_, Socket listen_socket_, SocketOptions const &socket_options_);
+	virtual ~Engine();
+	void setup(); //(the constructor's work; throws, leaving anything it made for release())
+	void release(); //closes the ring and unmaps whatever has been mapped
+
+	virtual void poll(
+		std::list< Connection > &connections,
+		std::function< void(Connection *, Connection::Event event) > const &on_event,
+		double timeout
+	) override;
+
+	char const *where;
+	Socket listen_socket;
+	SocketOptions socket_options;
+
+	int ring_fd = -1;
+
+	//submission queue:
+	void *sq_ring = MAP_FAILED;
+	size_t sq_ring_size = 0;
+	uint32_t *sq_head = nullptr;
+	uint32_t *sq_tail = nullptr;
+	uint32_t *sq_array = nullptr;
+	uint32_t sq_mask = 0;
+	uint32_t sq_entries = 0;
+	io_uring_sqe *sqes = reinterpret_cast< io_uring_sqe * >(MAP_FAILED);
+	size_t sqes_size = 0;
+	uint32_t sq_local_tail = 0; //sqes filled in but not yet handed to the kernel
+	uint32_t unsubmitted = 0;
+
+	//completion queue:
+	void *cq_ring = MAP_FAILED;
+	size_t cq_ring_size = 0;
+	uint32_t *cq_head = nullptr;
+	uint32_t *cq_tail = nullptr;
+	uint32_t cq_mask = 0;
+	io_uring_cqe *cqes = nullptr;
+
+	//provided buffers that multishot recv reads into:
+	// (via a registered buffer ring if the kernel's works, otherwise via IORING_OP_PROVIDE_BUFFERS)
+	bool use_buf_ring = false;
+	io_uring_buf_ring *buf_ring = reinterpret_cast< io_uring_buf_ring * >(MAP_FAILED);
+	size_t buf_ring_size = 0;
+	uint16_t buf_tail = 0;
+	std::vector< uint8_t > buf_storage;
+
+	bool accept_armed = false;
+
+	//per-socket bookkeeping:
+	struct Entry {
+		Connection *connection = nullptr; //nullptr once the connection has been closed
+		Socket socket = InvalidSocket;
+		bool recv_armed = false;
+		bool sending = false;
+		uint32_t in_flight = 0; //submissions that haven't delivered their final completion
+		std::vector< uint8_t > send_data; //owned by the kernel while 'sending'
+	};
+	std::unordered_map< uint64_t, Entry > entries;
+	std::unordered_map< Connection *, uint64_t > connection_to_entry;
+	uint64_t next_entry = 1; //(0 is reserved for the listen socket)
+
+	io_uring_sqe *get_sqe();
+	void submit(double wait);
+
+	bool buffer_ring_works();
+	void add_buffers(uint16_t bid, uint16_t count = 1);
+	void arm_accept();
+	void track(Connection *connection);
+	void arm_recv(uint64_t id, Entry &entry);
+	void start_send(uint64_t id, Entry &entry);
+	void cancel(uint64_t id, Op op);
+	void detach_closed();
+
+	//the connection to deliver events to (or nullptr if it has been closed):
+	static Connection *live(Entry const &entry) {
+		if (entry.connection && entry.connection->socket != InvalidSocket) return entry.connection;
+		return nullptr;
+	}
+};
+
+Engine::Engine(char const *where_, Socket listen_socket_, SocketOptions const &socket_options_)
+	: where(where_), listen_socket(listen_socket_), socket_options(socket_options_) {
+	//~Engine() doesn't run if the constructor throws, and IOUringEngine::create() survives
+	// the throw (falling back to select), so clean up a partly-built ring here:
+	try {
+		setup();
+	} catch (...) {
+		release();
+		throw;
+	}
+}
+
+void Engine::setup() {
+	{ //create the ring:
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		params.flags = IORING_SETUP_CQSIZE;
+		params.cq_entries = CompletionEntries;
+
+		ring_fd = sys_io_uring_setup(SubmissionEntries, &params);
+		if (ring_fd < 0) {
+			throw std::runtime_error("io_uring_setup failed: " + std::string(strerror(errno)));
+		}
+
+		uint32_t const required = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+		if ((params.features & required) != required) {
+			throw std::runtime_error("kernel's io_uring is missing NODROP / EXT_ARG (needs linux 5.11+)");
+		}
+
+		sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+		}
+
+		sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+		if (sq_ring == MAP_FAILED) {
+			throw std::runtime_error("failed to map io_uring submission queue: " + std::string(strerror(errno)));
+		}
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			cq_ring = sq_ring;
+		} else {
+			cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+			if (cq_ring == MAP_FAILED) {
+				throw std::runtime_error("failed to map io_uring completion queue: " + std::string(strerror(errno)));
+			}
+		}
+
+		sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		sqes = reinterpret_cast< io_uring_sqe * >(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+		if (sqes == MAP_FAILED) {
+			throw std::runtime_error("failed to map io_uring sqes: " + std::string(strerror(errno)));
+		}
+
+		uint8_t *sq = reinterpret_cast< uint8_t * >(sq_ring);
+		sq_head = reinterpret_cast< uint32_t * >(sq + params.sq_off.head);
+		sq_tail = reinterpret_cast< uint32_t * >(sq + params.sq_off.tail);
+		sq_array = reinterpret_cast< uint32_t * >(sq + params.sq_off.array);
+		sq_mask = *reinterpret_cast< uint32_t * >(sq + params.sq_off.ring_mask);
+		sq_entries = *reinterpret_cast< uint32_t * >(sq + params.sq_off.ring_entries);
+		sq_local_tail = *sq_tail;
+
+		uint8_t *cq = reinterpret_cast< uint8_t * >(cq_ring);
+		cq_head = reinterpret_cast< uint32_t * >(cq + params.cq_off.head);
+		cq_tail = reinterpret_cast< uint32_t * >(cq + params.cq_off.tail);
+		cq_mask = *reinterpret_cast< uint32_t * >(cq + params.cq_off.ring_mask);
+		cqes = reinterpret_cast< io_uring_cqe * >(cq + params.cq_off.cqes);
+	}
+
+	buf_storage.resize(size_t(RecvBufferCount) * RecvBufferSize);
+
+	{ //try to register a ring of provided buffers for recv:
+		static_assert((RecvBufferCount & (RecvBufferCount - 1)) == 0, "buffer ring size must be a power of two");
+		buf_ring_size = RecvBufferCount * sizeof(io_uring_buf);
+		//(the buffer ring needs to be page-aligned, so it gets its own anonymous mapping)
+		buf_ring = reinterpret_cast< io_uring_buf_ring * >(mmap(nullptr, buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (buf_ring == MAP_FAILED) {
+			throw std::runtime_error("failed to allocate io_uring buffer ring: " + std::string(strerror(errno)));
+		}
+		memset(reinterpret_cast< void * >(buf_ring), 0, buf_ring_size);
+
+		io_uring_buf_reg reg;
+		memset(&reg, 0, sizeof(reg));
+		reg.ring_addr = reinterpret_cast< uint64_t >(buf_ring);
+		reg.ring_entries = RecvBufferCount;
+		reg.bgid = RecvBufferGroup;
+		if (sys_io_uring_register(ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0) {
+			use_buf_ring = true;
+			add_buffers(0, RecvBufferCount);
+			if (!buffer_ring_works()) {
+				sys_io_uring_register(ring_fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+				use_buf_ring = false;
+			}
+		}
+		if (!use_buf_ring) {
+			//older kernels (before 5.19), or ring registration that doesn't deliver buffers:
+			add_buffers(0, RecvBufferCount);
+		}
+	}
+
+	if (listen_socket != InvalidSocket) {
+		arm_accept();
+	}
+
+	std::cout << "[" << where << "] using io_uring (" << (use_buf_ring ? "buffer ring" : "provided buffers") << ")." << std::endl;
+}
+
+Engine::~Engine() {
+	release();
+}
+
+void Engine::release() {
+	//closing the ring cancels anything still in flight:
+	if (ring_fd >= 0) ::close(ring_fd);
+	ring_fd = -1;
+	if (buf_ring != MAP_FAILED) munmap(buf_ring, buf_ring_size);
+	buf_ring = reinterpret_cast< io_uring_buf_ring * >(MAP_FAILED);
+	if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+	sqes = reinterpret_cast< io_uring_sqe * >(MAP_FAILED);
+	if (cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+	cq_ring = MAP_FAILED;
+	if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+	sq_ring = MAP_FAILED;
+}
+
+io_uring_sqe *Engine::get_sqe() {
+	if (sq_local_tail - load_acquire(sq_head) >= sq_entries) {
+		//queue is full; hand what we have to the kernel to make room:
+		submit(0.0);
+		if (sq_local_tail - load_acquire(sq_head) >= sq_entries) {
+			throw std::runtime_error("io_uring submission queue is full");
+		}
+	}
+	uint32_t index = sq_local_tail & sq_mask;
+	io_uring_sqe *sqe = &sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sq_array[index] = index;
+	sq_local_tail += 1;
+	unsubmitted += 1;
+	return sqe;
+}
+
+//hand queued sqes to the kernel; if wait > 0, also wait up to 'wait' seconds for a completion:
+void Engine::submit(double wait) {
+	store_release(sq_tail, sq_local_tail);
+
+	__kernel_timespec ts;
+	ts.tv_sec = std::lround(std::floor(wait));
+	ts.tv_nsec = std::lround((wait - std::floor(wait)) * 1e9);
+
+	io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	arg.ts = reinterpret_cast< uint64_t >(&ts);
+
+	unsigned flags = IORING_ENTER_EXT_ARG;
+	unsigned min_complete = 0;
+	if (wait > 0.0 && load_acquire(cq_tail) == *cq_head) {
+		flags |= IORING_ENTER_GETEVENTS;
+		min_complete = 1;
+	}
+	if (unsubmitted == 0 && min_complete == 0) return;
+
+	int ret = sys_io_uring_enter(ring_fd, unsubmitted, min_complete, flags, &arg, sizeof(arg));
+	if (ret < 0) {
+		if (errno != ETIME && errno != EINTR && errno != EBUSY) {
+			std::cerr << "[" << where << "] io_uring_enter returned error " << errno << "(" << strerror(errno) << ")." << std::endl;
+		}
+	} else {
+		unsubmitted -= uint32_t(ret);
+	}
+}
+
+//hand buffers [bid, bid + count) to the kernel for recv to fill:
+void Engine::add_buffers(uint16_t bid, uint16_t count) {
+	if (use_buf_ring) {
+		for (uint16_t i = 0; i < count; ++i) {
+			io_uring_buf &buf = buf_ring->bufs[buf_tail & (RecvBufferCount - 1)];
+			buf.addr = reinterpret_cast< uint64_t >(buf_storage.data() + size_t(bid + i) * RecvBufferSize);
+			buf.len = RecvBufferSize;
+			buf.bid = uint16_t(bid + i);
+			buf_tail += 1;
+		}
+		store_release(&buf_ring->tail, buf_tail);
+	} else {
+		io_uring_sqe *sqe = get_sqe();
+		sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+		sqe->fd = count;
+		sqe->addr = reinterpret_cast< uint64_t >(buf_storage.data() + size_t(bid) * RecvBufferSize);
+		sqe->len = RecvBufferSize;
+		sqe->off = bid;
+		sqe->buf_group = RecvBufferGroup;
+		sqe->user_data = pack(0, OpHousekeeping);
+	}
+}
+
+//some kernels accept a buffer ring registration but then never hand out its buffers
+// (every recv fails with ENOBUFS), so check with one recv on a socket pair:
+bool Engine::buffer_ring_works() {
+	int pair[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) return false;
+
+	bool works = false;
+	if (::write(pair[1], "?", 1) == 1) {
+		io_uring_sqe *sqe = get_sqe();
+		sqe->opcode = IORING_OP_RECV;
+		sqe->fd = pair[0];
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = RecvBufferGroup;
+		sqe->user_data = pack(0, OpHousekeeping);
+		submit(1.0);
+
+		uint32_t head = *cq_head;
+		if (head != load_acquire(cq_tail)) {
+			io_uring_cqe cqe = cqes[head & cq_mask];
+			store_release(cq_head, head + 1);
+			works = (cqe.res == 1);
+			if (cqe.flags & IORING_CQE_F_BUFFER) add_buffers(uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+		}
+	}
+
+	::close(pair[0]);
+	::close(pair[1]);
+	return works;
+}
+
+void Engine::arm_accept() {
+	io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = listen_socket;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	sqe->user_data = pack(0, OpAccept);
+	accept_armed = true;
+}
+
+void Engine::track(Connection *connection) {
+	uint64_t id = next_entry++;
+	Entry &entry = entries[id];
+	entry.connection = connection;
+	entry.socket = connection->socket;
+	connection_to_entry.emplace(connection, id);
+	arm_recv(id, entry);
+}
+
+void Engine::arm_recv(uint64_t id, Entry &entry) {
+	io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = entry.socket;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = RecvBufferGroup;
+	sqe->len = 0; //(each recv fills at most one provided buffer)
+	sqe->user_data = pack(id, OpRecv);
+	entry.recv_armed = true;
+	entry.in_flight += 1;
+}
+
+void Engine::start_send(uint64_t id, Entry &entry) {
+	assert(!entry.sending && entry.connection);
+	//take the whole send buffer (the connection gets the old, empty, vector back to keep appending to):
+	std::swap(entry.send_data, entry.connection->send_buffer);
+	entry.connection->send_buffer.clear();
+
+	io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = entry.socket;
+	sqe->addr = reinterpret_cast< uint64_t >(entry.send_data.data());
+	sqe->len = uint32_t(entry.send_data.size());
+	sqe->msg_flags = MSG_NOSIGNAL;
+	sqe->user_data = pack(id, OpSend);
+	entry.sending = true;
+	entry.in_flight += 1;
+}
+
+void Engine::cancel(uint64_t id, Op op) {
+	io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = pack(id, op);
+	sqe->user_data = pack(id, OpHousekeeping);
+}
+
+//stop watching connections that have been closed (by us, or by user code calling Connection::close()):
+void Engine::detach_closed() {
+	for (auto ei = entries.begin(); ei != entries.end(); /* later */) {
+		uint64_t id = ei->first;
+		Entry &entry = ei->second;
+		if (entry.connection && entry.connection->socket == InvalidSocket) {
+			connection_to_entry.erase(entry.connection);
+			entry.connection = nullptr;
+			//(closing the socket doesn't end requests that already hold it, so cancel them explicitly)
+			if (entry.recv_armed) cancel(id, OpRecv);
+			if (entry.sending) cancel(id, OpSend);
+		}
+		if (!entry.connection && entry.in_flight == 0) {
+			ei = entries.erase(ei);
+		} else {
+			++ei;
+		}
+	}
+}
+
+void Engine::poll(
+	std::list< Connection > &connections,
+	std::function< void(Connection *, Connection::Event event) > const &on_event,
+	double timeout) {
+
+	detach_closed();
+
+	//watch any connections this engine hasn't seen yet (e.g., Client's connection on the first poll):
+	for (auto &c : connections) {
+		if (c.socket != InvalidSocket && !connection_to_entry.count(&c)) track(&c);
+	}
+
+	if (listen_socket != InvalidSocket && !accept_armed) arm_accept();
+
+	auto queue_sends = [&]() {
+		for (auto &[id, entry] : entries) {
+			Connection *c = live(entry);
+			if (c && !entry.recv_armed) {
+				//multishot recv stopped (ran out of provided buffers) -- start it up again:
+				arm_recv(id, entry);
+			}
+			if (c && !entry.sending && !c->send_buffer.empty()) start_send(id, entry);
+		}
+	};
+	queue_sends();
+
+	//submit everything queued so far and wait (until timeout) for the first completion:
+	submit(timeout);
+
+	//process completions:
+	uint32_t head = *cq_head;
+	while (head != load_acquire(cq_tail)) {
+		io_uring_cqe cqe = cqes[head & cq_mask];
+		head += 1;
+		store_release(cq_head, head); //(copied the cqe, so the slot can be reused right away)
+
+		uint64_t id = cqe.user_data >> 2;
+		Op op = Op(cqe.user_data & 3);
+
+		if (op == OpHousekeeping) continue; //(a cancelled request reports on its own)
+
+		if (op == OpAccept) {
+			if (!(cqe.flags & IORING_CQE_F_MORE)) accept_armed = false; //re-armed on next poll
+			if (cqe.res < 0) {
+				if (cqe.res != -ECANCELED && cqe.res != -ECONNABORTED) {
+					std::cerr << "[" << where << "] accept returned error " << -cqe.res << "(" << strerror(-cqe.res) << ")." << std::endl;
+				}
+				continue;
+			}
+			Socket got = cqe.res;
+			apply_socket_options(where, got, socket_options);
+
+			connections.emplace_back();
+			connections.back().socket = got;
+			track(&connections.back());
+			std::cerr << "[" << where << "] client connected on " << connections.back().socket << "." << std::endl; //INFO
+			if (on_event) on_event(&connections.back(), Connection::OnOpen);
+			continue;
+		}
+
+		auto f = entries.find(id);
+		if (f == entries.end()) {
+			std::cerr << "[" << where << "] completion for unknown connection; ignoring." << std::endl;
+			continue;
+		}
+		Entry &entry = f->second;
+
+		if (op == OpRecv) {
+			if (!(cqe.flags & IORING_CQE_F_MORE)) {
+				entry.recv_armed = false;
+				entry.in_flight -= 1;
+			}
+			Connection *c = live(entry);
+			if (cqe.flags & IORING_CQE_F_BUFFER) {
+				uint16_t bid = uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+				if (c && cqe.res > 0) {
+					uint8_t const *data = buf_storage.data() + size_t(bid) * RecvBufferSize;
+					c->recv_buffer.insert(c->recv_buffer.end(), data, data + cqe.res);
+				}
+				add_buffers(bid); //give the buffer back to the kernel
+			}
+			if (!c) continue;
+
+			if (cqe.res > 0) {
+				if (on_event) on_event(c, Connection::OnRecv);
+			} else if (cqe.res == -ENOBUFS) {
+				//~no problem~ recv will be re-armed once buffers are returned
+			} else if (cqe.res != -ECANCELED) {
+				if (cqe.res == 0) {
+					std::cerr << "[" << where << "] port closed, disconnecting." << std::endl;
+				} else {
+					std::cerr << "[" << where << "] recv() returned error " << -cqe.res << "(" << strerror(-cqe.res) << "), disconnecting." << std::endl;
+				}
+				c->close();
+				if (on_event) on_event(c, Connection::OnClose);
+			}
+		} else { assert(op == OpSend);
+			entry.sending = false;
+			entry.in_flight -= 1;
+			Connection *c = live(entry);
+			if (cqe.res >= 0) {
+				//keep anything the kernel didn't take (short send) at the front of the send buffer:
+				if (c && uint32_t(cqe.res) < entry.send_data.size()) {
+					c->send_buffer.insert(c->send_buffer.begin(), entry.send_data.begin() + cqe.res, entry.send_data.end());
+				}
+			} else if (c && cqe.res != -ECANCELED) {
+				std::cerr << "[" << where << "] send() returned error " << -cqe.res << ", disconnecting." << std::endl;
+				c->close();
+				if (on_event) on_event(c, Connection::OnClose);
+			}
+			entry.send_data.clear();
+		}
+	}
+
+	//anything the callbacks queued goes out in one more (non-waiting) submission:
+	detach_closed();
+	queue_sends();
+	submit(0.0);
+}
+
+} //namespace
+
+std::unique_ptr< IOUringEngine > IOUringEngine::create(char const *where, Socket listen_socket, SocketOptions const &socket_options) {
+	try {
+		return std::make_unique< Engine >(where, listen_socket, socket_options);
+	} catch (std::exception const &e) {
+		std::cerr << "[" << where << "] io_uring unavailable (" << e.what() << "); using select()." << std::endl;
+		return nullptr;
+	}
+}
+
+#else //no io_uring:
+
+std::unique_ptr< IOUringEngine > IOUringEngine::create(char const *where, Socket listen_socket, SocketOptions const &socket_options) {
+	std::cerr << "[" << where << "] io_uring is not available on this platform; using select()." << std::endl;
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+ * IOUringEngine is the io_uring (linux) implementation behind
+ *  Server::poll() / Client::poll() when io_engine is IOEngine::IOUring.
+ *
+ * It keeps a multishot accept armed on the listen socket, a multishot recv
+ *  (reading into a ring of kernel-provided buffers) armed on every connection,
+ *  and at most one send in flight per connection; everything queued during a
+ *  poll() reaches the kernel in a single io_uring_enter() call.
+ *
+ * You don't use this directly; set Server::io_engine or Client::io_engine.
+ */
+
+#include "Connection.hpp"
+
+#include <memory>
+
+struct IOUringEngine {
+	//set up a ring (and arm accepts on listen_socket, if it is valid):
+	// returns nullptr (after printing why) if io_uring isn't usable on this system.
+	static std::unique_ptr< IOUringEngine > create(char const *where, Socket listen_socket, SocketOptions const &socket_options);
+	virtual ~IOUringEngine() = default;
+
+	//same contract as the select()-based poll:
+	virtual void poll(
+		std::list< Connection > &connections,
+		std::function< void(Connection *, Connection::Event event) > const &on_event,
+		double timeout
+	) = 0;
+};
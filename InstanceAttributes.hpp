@@ -0,0 +1,13 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+//Per-instance data for instanced drawing, laid out as in the instance buffer:
+// Scene fills these in (as Scene::Instance) and MeshBuffer::make_vao_for_program points
+// the CLIP_FROM_OBJECT, LIGHT_FROM_OBJECT, and LIGHT_FROM_NORMAL attributes at them.
+struct InstanceAttributes {
+	glm::mat4 clip_from_object;
+	glm::mat4x3 light_from_object;
+	glm::mat3 light_from_normal;
+};
+static_assert(sizeof(InstanceAttributes) == 4*16 + 4*12 + 4*9, "InstanceAttributes is packed.");
@@ -5,23 +5,17 @@
 
 Scene::Drawable::Pipeline lit_color_texture_program_pipeline;
 
-Load< LitColorTextureProgram > lit_color_texture_program(LoadTagEarly, []() -> LitColorTextureProgram const * {
-	LitColorTextureProgram *ret = new LitColorTextureProgram();
+//(shaders for all programs are submitted before any is waited for, so they can compile at the same time)
+Load< LitColorTextureProgram > lit_color_texture_program(LoadTagEarly, LoadSubmitFirst(), []() {
+	return LitColorTextureProgram::submit();
+}, [](GLProgramBuild &&build) -> LitColorTextureProgram const * {
+	LitColorTextureProgram *ret = new LitColorTextureProgram(std::move(build), false);
 
 	//----- build the pipeline template -----
 	lit_color_texture_program_pipeline.program = ret->program;
 
-	lit_color_texture_program_pipeline.CLIP_FROM_OBJECT_mat4 = ret->CLIP_FROM_OBJECT_mat4;
-	lit_color_texture_program_pipeline.LIGHT_FROM_OBJECT_mat4x3 = ret->LIGHT_FROM_OBJECT_mat4x3;
-	lit_color_texture_program_pipeline.LIGHT_FROM_NORMAL_mat3 = ret->LIGHT_FROM_NORMAL_mat3;
-
-	/* This will be used later if/when we build a light loop into the Scene:
-	lit_color_texture_program_pipeline.LIGHT_TYPE_int = ret->LIGHT_TYPE_int;
-	lit_color_texture_program_pipeline.LIGHT_LOCATION_vec3 = ret->LIGHT_LOCATION_vec3;
-	lit_color_texture_program_pipeline.LIGHT_DIRECTION_vec3 = ret->LIGHT_DIRECTION_vec3;
-	lit_color_texture_program_pipeline.LIGHT_ENERGY_vec3 = ret->LIGHT_ENERGY_vec3;
-	lit_color_texture_program_pipeline.LIGHT_CUTOFF_float = ret->LIGHT_CUTOFF_float;
-	*/
+	//(matrices come from the 'Object' uniform block and lighting from the 'Frame' block; see Scene::frame_uniforms)
+	lit_color_texture_program_pipeline.object_block = true;
 
 	//make a 1-pixel white texture to bind by default:
 	GLuint tex;
@@ -43,14 +37,30 @@ Load< LitColorTextureProgram > lit_color_texture_program(LoadTagEarly, []() -> L
 	return ret;
 });
 
-LitColorTextureProgram::LitColorTextureProgram() {
-	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
-	program = gl_compile_program(
+Load< LitColorTextureProgram > lit_color_texture_program_instanced(LoadTagEarly, LoadSubmitFirst(), []() {
+	return LitColorTextureProgram::submit(true);
+}, [](GLProgramBuild &&build) -> LitColorTextureProgram const * {
+	LitColorTextureProgram *ret = new LitColorTextureProgram(std::move(build), true);
+
+	//----- add the instanced version to the pipeline template -----
+	lit_color_texture_program_pipeline.instanced.program = ret->program;
+	lit_color_texture_program_pipeline.instanced.buffer = ret->instance_buffer;
+
+	return ret;
+});
+
+GLProgramBuild LitColorTextureProgram::submit(bool instanced) {
+	//Start compiling vertex and fragment shaders using the convenient 'gl_submit_program' helper function:
+	// (the constructor waits for the result)
+	return gl_submit_program(
 		//vertex shader:
-		"#version 330\n"
-		"uniform mat4 CLIP_FROM_OBJECT;\n"
-		"uniform mat4x3 LIGHT_FROM_OBJECT;\n"
-		"uniform mat3 LIGHT_FROM_NORMAL;\n"
+		std::string("#version 330\n")
+		+ (instanced ?
+		"in mat4 CLIP_FROM_OBJECT;\n" //(per-instance attributes)
+		"in mat4x3 LIGHT_FROM_OBJECT;\n"
+		"in mat3 LIGHT_FROM_NORMAL;\n"
+		: Scene::ObjectBlockGLSL
+		) +
 		"in vec4 Position;\n"
 		"in vec3 Normal;\n"
 		"in vec4 Color;\n"
@@ -68,13 +78,9 @@ LitColorTextureProgram::LitColorTextureProgram() {
 		"}\n"
 	,
 		//fragment shader:
-		"#version 330\n"
+		std::string("#version 330\n")
+		+ Scene::FrameBlockGLSL +
 		"uniform sampler2D TEX;\n"
-		"uniform int LIGHT_TYPE;\n"
-		"uniform vec3 LIGHT_LOCATION;\n"
-		"uniform vec3 LIGHT_DIRECTION;\n"
-		"uniform vec3 LIGHT_ENERGY;\n"
-		"uniform float LIGHT_CUTOFF;\n"
 		"in vec3 position;\n"
 		"in vec3 normal;\n"
 		"in vec4 color;\n"
@@ -124,6 +130,11 @@ LitColorTextureProgram::LitColorTextureProgram() {
 	);
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
+}
+
+LitColorTextureProgram::LitColorTextureProgram(GLProgramBuild &&build, bool instanced) {
+	//wait for the shaders submitted by submit() to finish compiling:
+	program = gl_await_program(std::move(build));
 
 	//look up the locations of vertex attributes:
 	Position_vec4 = glGetAttribLocation(program, "Position");
@@ -131,17 +142,11 @@ LitColorTextureProgram::LitColorTextureProgram() {
 	Color_vec4 = glGetAttribLocation(program, "Color");
 	TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
 
-	//look up the locations of uniforms:
-	CLIP_FROM_OBJECT_mat4 = glGetUniformLocation(program, "CLIP_FROM_OBJECT");
-	LIGHT_FROM_OBJECT_mat4x3 = glGetUniformLocation(program, "LIGHT_FROM_OBJECT");
-	LIGHT_FROM_NORMAL_mat3 = glGetUniformLocation(program, "LIGHT_FROM_NORMAL");
-
-	LIGHT_TYPE_int = glGetUniformLocation(program, "LIGHT_TYPE");
-	LIGHT_LOCATION_vec3 = glGetUniformLocation(program, "LIGHT_LOCATION");
-	LIGHT_DIRECTION_vec3 = glGetUniformLocation(program, "LIGHT_DIRECTION");
-	LIGHT_ENERGY_vec3 = glGetUniformLocation(program, "LIGHT_ENERGY");
-	LIGHT_CUTOFF_float = glGetUniformLocation(program, "LIGHT_CUTOFF");
-
+	//point uniform blocks at the binding points Scene::draw fills in:
+	GLuint Frame_block = glGetUniformBlockIndex(program, "Frame");
+	if (Frame_block != GL_INVALID_INDEX) glUniformBlockBinding(program, Frame_block, Scene::FrameBinding);
+	GLuint Object_block = glGetUniformBlockIndex(program, "Object");
+	if (Object_block != GL_INVALID_INDEX) glUniformBlockBinding(program, Object_block, Scene::ObjectBinding);
 
 	GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
 
@@ -151,9 +156,17 @@ LitColorTextureProgram::LitColorTextureProgram() {
 	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
 
 	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+
+	if (instanced) {
+		glGenBuffers(1, &instance_buffer);
+	}
 }
 
 LitColorTextureProgram::~LitColorTextureProgram() {
+	if (instance_buffer != 0) {
+		glDeleteBuffers(1, &instance_buffer);
+		instance_buffer = 0;
+	}
 	glDeleteProgram(program);
 	program = 0;
 }
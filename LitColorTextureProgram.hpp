@@ -1,12 +1,18 @@
 #pragma once
 
 #include "GL.hpp"
+#include "gl_compile_program.hpp"
 #include "Load.hpp"
 #include "Scene.hpp"
 
 //Shader program that draws transformed, lit, textured vertices tinted with vertex colors:
+// (the 'instanced' version reads its CLIP_FROM_OBJECT, LIGHT_FROM_OBJECT, and LIGHT_FROM_NORMAL matrices
+//  from per-instance attributes instead of a uniform block; see Scene::Drawable::Pipeline::instanced)
 struct LitColorTextureProgram {
-	LitColorTextureProgram();
+	//start compiling the shaders (see gl_submit_program); the constructor waits for them to finish:
+	static GLProgramBuild submit(bool instanced = false);
+	LitColorTextureProgram(GLProgramBuild &&build, bool instanced);
+	LitColorTextureProgram(bool instanced = false) : LitColorTextureProgram(submit(instanced), instanced) { }
 	~LitColorTextureProgram();
 
 	GLuint program = 0;
@@ -17,24 +23,22 @@ struct LitColorTextureProgram {
 	GLuint Color_vec4 = -1U;
 	GLuint TexCoord_vec2 = -1U;
 
-	//Uniform (per-invocation variable) locations:
-	GLuint CLIP_FROM_OBJECT_mat4 = -1U;
-	GLuint LIGHT_FROM_OBJECT_mat4x3 = -1U;
-	GLuint LIGHT_FROM_NORMAL_mat3 = -1U;
-
-	//lighting:
-	GLuint LIGHT_TYPE_int = -1U;
-	GLuint LIGHT_LOCATION_vec3 = -1U;
-	GLuint LIGHT_DIRECTION_vec3 = -1U;
-	GLuint LIGHT_ENERGY_vec3 = -1U;
-	GLuint LIGHT_CUTOFF_float = -1U;
-	
+	//Uniforms:
+	// CLIP_FROM_OBJECT, LIGHT_FROM_OBJECT, LIGHT_FROM_NORMAL come from the 'Object' uniform block (Scene::ObjectUniforms),
+	//  or from per-instance attributes in the instanced version;
+	// lighting comes from the 'Frame' uniform block (Scene::FrameUniforms -- set via Scene::frame_uniforms).
+
 	//Textures:
 	//TEXTURE0 - texture that is accessed by TexCoord
+
+	//(instanced version only) buffer that Scene::draw uploads per-instance matrices to:
+	GLuint instance_buffer = 0;
 };
 
 extern Load< LitColorTextureProgram > lit_color_texture_program;
+extern Load< LitColorTextureProgram > lit_color_texture_program_instanced;
 
 //For convenient scene-graph setup, copy this object:
 // NOTE: by default, has texture bound to 1-pixel white texture -- so it's okay to use with vertex-color-only meshes.
+// NOTE: set instanced.vao (along with vao) to let Scene::draw instance repeated meshes.
 extern Scene::Drawable::Pipeline lit_color_texture_program_pipeline;
@@ -1,20 +1,86 @@
 #include "Load.hpp"
 
-#include <array>
-#include <list>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <cassert>
 
 namespace {
-	std::array< std::list< std::function< void() > >, MaxLoadTag > &get_load_lists() {
-		static std::array< std::list< std::function< void() > >, MaxLoadTag > load_lists;
-		return load_lists;
+	struct LoadFunction {
+		LoadTag tag;
+		std::function< void() > submit; //called on the main thread before any upload (empty for most load functions)
+		std::function< void() > read; //called on a worker thread (empty for single-part load functions)
+		std::function< void() > upload; //called on the main thread
+		bool explicit_after = false;
+		std::vector< void const * > after; //owners of the load functions 'upload' waits for (if explicit_after)
+		void const *owner = nullptr;
+		std::string name;
+
+		//filled in by call_load_functions():
+		std::vector< uint32_t > waits_for; //indices of load functions 'upload' waits for
+		bool read_done = false;
+		bool upload_done = false;
+		double submit_begin = 0.0, submit_end = 0.0; //(seconds since call_load_functions() started)
+		double read_begin = 0.0, read_end = 0.0;
+		double upload_begin = 0.0, upload_end = 0.0;
+		uint32_t uploaded_after = -1U; //upload that ran just before this one on the main thread
+	};
+
+	std::vector< LoadFunction > &get_load_functions() {
+		static std::vector< LoadFunction > load_functions;
+		return load_functions;
 	}
+
+	std::string name_of(std::source_location const &where) {
+		std::string file = where.file_name();
+		file = file.substr(file.find_last_of("/\\") + 1);
+		return file + ":" + std::to_string(where.line());
+	}
+}
+
+void add_load_function(LoadTag tag, std::function< void() > const &fn, void const *owner, std::source_location where) {
+	assert(tag < MaxLoadTag);
+	LoadFunction lf;
+	lf.tag = tag;
+	lf.upload = fn;
+	lf.owner = owner;
+	lf.name = name_of(where);
+	get_load_functions().emplace_back(std::move(lf));
+}
+
+void add_load_function(LoadTag tag, std::function< void() > const &read, std::function< void() > const &upload,
+	std::vector< void const * > const &after, void const *owner, std::source_location where) {
+	assert(tag < MaxLoadTag);
+	LoadFunction lf;
+	lf.tag = tag;
+	lf.read = read;
+	lf.upload = upload;
+	lf.explicit_after = !after.empty();
+	lf.after = after;
+	lf.owner = owner;
+	lf.name = name_of(where);
+	get_load_functions().emplace_back(std::move(lf));
 }
 
-void add_load_function(LoadTag tag, std::function< void() > const &fn) {
-	auto &load_lists = get_load_lists();
-	assert(tag < load_lists.size());
-	load_lists[tag].emplace_back(fn);
+void add_load_function(LoadTag tag, LoadSubmitFirst, std::function< void() > const &submit, std::function< void() > const &finish,
+	void const *owner, std::source_location where) {
+	assert(tag < MaxLoadTag);
+	LoadFunction lf;
+	lf.tag = tag;
+	lf.submit = submit;
+	lf.upload = finish;
+	lf.owner = owner;
+	lf.name = name_of(where);
+	get_load_functions().emplace_back(std::move(lf));
 }
 
 void call_load_functions() {
@@ -22,11 +88,212 @@ void call_load_functions() {
 	assert(!has_been_called && "call_load_functions should only be called *once*");
 	has_been_called = true;
 
-	auto &load_lists = get_load_lists();
-	for (auto &fn_list : load_lists) {
-		while (!fn_list.empty()) {
-			(*fn_list.begin())(); //call first function in the list
-			fn_list.pop_front(); //remove from list
+	auto &fns = get_load_functions();
+	//(uploads are preferred in tag order, then in the order they were added -- same as when everything ran serially)
+	std::stable_sort(fns.begin(), fns.end(), [](LoadFunction const &a, LoadFunction const &b) {
+		return a.tag < b.tag;
+	});
+
+	//turn tags and 'after' lists into edges:
+	std::unordered_map< void const *, uint32_t > by_owner;
+	for (uint32_t i = 0; i < fns.size(); ++i) {
+		if (fns[i].owner) by_owner[fns[i].owner] = i;
+	}
+	for (uint32_t i = 0; i < fns.size(); ++i) {
+		LoadFunction &fn = fns[i];
+		if (fn.explicit_after) {
+			for (void const *owner : fn.after) {
+				auto f = by_owner.find(owner);
+				if (f == by_owner.end()) {
+					throw std::runtime_error("Load function at " + fn.name + " waits for something that isn't being loaded.");
+				}
+				fn.waits_for.emplace_back(f->second);
+			}
+		} else {
+			for (uint32_t j = 0; j < i && fns[j].tag < fn.tag; ++j) {
+				fn.waits_for.emplace_back(j);
+			}
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto now = [&start]() {
+		return std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+	};
+
+	//worker-thread parts go in a queue shared with a small thread pool:
+	std::mutex mutex;
+	std::condition_variable read_finished;
+	std::condition_variable read_queued;
+	std::deque< uint32_t > reads;
+	std::exception_ptr error;
+	uint32_t reads_pending = 0;
+	bool stop = false;
+
+	for (uint32_t i = 0; i < fns.size(); ++i) {
+		if (fns[i].read) reads.emplace_back(i);
+		else fns[i].read_done = true;
+	}
+	reads_pending = uint32_t(reads.size());
+
+	//runs one read from the queue (call with 'lock' held; drops it while reading):
+	auto run_read = [&](std::unique_lock< std::mutex > &lock) {
+		uint32_t i = reads.front();
+		reads.pop_front();
+		lock.unlock();
+		double begin = now();
+		std::exception_ptr read_error;
+		try {
+			fns[i].read();
+		} catch (...) {
+			read_error = std::current_exception();
+		}
+		double end = now();
+		lock.lock();
+		fns[i].read_begin = begin;
+		fns[i].read_end = end;
+		fns[i].read_done = true;
+		reads_pending -= 1;
+		if (read_error && !error) error = read_error;
+		read_finished.notify_all();
+	};
+
+	struct Workers {
+		std::vector< std::thread > threads;
+		std::function< void() > on_stop;
+		~Workers() {
+			on_stop();
+			for (auto &thread : threads) thread.join();
+		}
+	} workers;
+	workers.on_stop = [&]() {
+		std::unique_lock< std::mutex > lock(mutex);
+		stop = true;
+		read_queued.notify_all();
+	};
+
+	//(the main thread also runs reads while it has no uploads to do, so it counts as one worker)
+	//(at least one extra thread even on a single core, since reads spend a lot of their time waiting on the disk)
+	uint32_t thread_count = std::max(2U, std::thread::hardware_concurrency()) - 1;
+	thread_count = std::min(thread_count, uint32_t(reads.size()));
+	for (uint32_t t = 0; t < thread_count; ++t) {
+		workers.threads.emplace_back([&]() {
+			std::unique_lock< std::mutex > lock(mutex);
+			while (true) {
+				read_queued.wait(lock, [&]() { return stop || !reads.empty(); });
+				if (stop) return;
+				run_read(lock);
+			}
+		});
+	}
+	read_queued.notify_all();
+
+	//main thread: run submits first, so what they start (e.g., shader compiles) goes on in the background during everything else:
+	uint32_t submits = 0;
+	double submits_begin = now();
+	for (auto &fn : fns) {
+		if (!fn.submit) continue;
+		fn.submit_begin = now();
+		fn.submit();
+		fn.submit_end = now();
+		submits += 1;
+	}
+	double submits_end = now();
+
+	//..then run uploads as they become ready:
+	uint32_t uploads_left = uint32_t(fns.size());
+	uint32_t last_upload = -1U;
+	while (uploads_left) {
+		std::unique_lock< std::mutex > lock(mutex);
+		if (error) break;
+
+		uint32_t ready = -1U;
+		for (uint32_t i = 0; i < fns.size() && ready == -1U; ++i) {
+			if (fns[i].upload_done || !fns[i].read_done) continue;
+			bool waiting = false;
+			for (uint32_t j : fns[i].waits_for) {
+				if (!fns[j].upload_done) {
+					waiting = true;
+					break;
+				}
+			}
+			if (!waiting) ready = i;
+		}
+
+		if (ready == -1U) {
+			if (!reads.empty()) {
+				run_read(lock);
+			} else if (reads_pending) {
+				read_finished.wait(lock);
+			} else {
+				throw std::runtime_error("Load functions wait for each other in a cycle.");
+			}
+			continue;
+		}
+		lock.unlock();
+
+		LoadFunction &fn = fns[ready];
+		fn.upload_begin = now();
+		fn.upload();
+		fn.upload_end = now();
+		fn.upload_done = true;
+		fn.uploaded_after = last_upload;
+		last_upload = ready;
+		uploads_left -= 1;
+	}
+
+	if (error) std::rethrow_exception(error);
+
+	//report:
+	// (formatted on its own stream, so std::cout's flags and precision are left alone)
+	std::ostringstream report;
+	report << std::fixed << std::setprecision(1);
+	double total = now();
+	double work = 0.0;
+	for (auto const &fn : fns) {
+		work += (fn.submit_end - fn.submit_begin) + (fn.read_end - fn.read_begin) + (fn.upload_end - fn.upload_begin);
+	}
+	report << "Ran " << fns.size() << " load functions in " << total * 1e3 << "ms"
+	       << " (" << work * 1e3 << "ms of work)." << '\n';
+
+	//critical path: walk back from the last upload, each time to whatever its start waited on longest:
+	struct Step {
+		uint32_t fn;
+		bool read;
+	};
+	std::vector< Step > path;
+	uint32_t at = last_upload;
+	while (at != -1U) {
+		LoadFunction const &fn = fns[at];
+		path.emplace_back(Step{at, false});
+
+		uint32_t next = fn.uploaded_after; //main thread was busy..
+		double next_end = (next != -1U ? fns[next].upload_end : 0.0);
+		for (uint32_t j : fn.waits_for) { //..or a dependency wasn't done..
+			if (fns[j].upload_end > next_end) {
+				next = j;
+				next_end = fns[j].upload_end;
+			}
+		}
+		if (fn.read && fn.read_end > next_end) { //..or the read wasn't done:
+			path.emplace_back(Step{at, true});
+			break; //(reads start as soon as a thread is free)
 		}
+		at = next;
+	}
+	report << " critical path:" << '\n';
+	if (at == -1U && submits) { //(the first upload waited for the submits)
+		report << "  " << std::setw(7) << submits_begin * 1e3 << "ms +" << std::setw(6) << (submits_end - submits_begin) * 1e3 << "ms "
+		       << "submit  (" << submits << " load functions)" << '\n';
 	}
+	for (auto s = path.rbegin(); s != path.rend(); ++s) {
+		LoadFunction const &fn = fns[s->fn];
+		double begin = (s->read ? fn.read_begin : fn.upload_begin);
+		double end = (s->read ? fn.read_end : fn.upload_end);
+		report << "  " << std::setw(7) << begin * 1e3 << "ms +" << std::setw(6) << (end - begin) * 1e3 << "ms "
+		       << (s->read ? "read   " : "upload ") << fn.name << '\n';
+	}
+	std::cout << report.str() << std::flush;
+
+	fns.clear();
 }
@@ -20,10 +20,46 @@
  * These functions are grouped by 'tags', which allow some sequencing of calls.
  * (particularly, this is useful for loading large data blobs [e.g. Meshes] before looking up individual elements within them.)
  *
+ * Loading can also be split in two, so the slow part runs on a pool of worker threads:
+ *
+ * Load< MeshBuffer > level_meshes(LoadTagDefault, []() {
+ *     //called on a worker thread -- file I/O and decoding only (no GL calls, no other Load<>s):
+ *     return std::make_unique< MeshBuffer >(data_path("level.pnct"), MeshBuffer::Deferred());
+ * }, [](std::unique_ptr< MeshBuffer > &&meshes) -> MeshBuffer const * {
+ *     //called on the main thread with the result -- GL calls are fine here:
+ *     // (hold it in a unique_ptr until here, so it isn't leaked if something throws first)
+ *     meshes->upload();
+ *     return meshes.release();
+ * }, { &lit_color_texture_program }); //<-- Load<>s the second function uses
+ *
+ * Or split so that all the first halves run before anything else does -- for
+ *  GL work the driver can do in the background, like compiling shaders:
+ *
+ * Load< ColorProgram > color_program(LoadTagEarly, LoadSubmitFirst(), []() {
+ *     //called on the main thread before any other load function's main-thread part:
+ *     return ColorProgram::submit();
+ * }, [](GLProgramBuild &&build) -> ColorProgram const * {
+ *     //called on the main thread at the usual point for its tag:
+ *     return new ColorProgram(std::move(build));
+ * });
+ *
+ * Tags are dependency edges rather than barriers: the main-thread part of a
+ *  load function waits for the functions it lists (or, if it lists none, for
+ *  every function with an earlier tag) and for its own worker-thread part,
+ *  but worker-thread parts all start right away.
+ *
+ * call_load_functions() prints the critical path of the whole process, to
+ *  show which loads startup time is actually waiting on.
+ *
  */
 
 #include <functional>
 #include <stdexcept>
+#include <optional>
+#include <memory>
+#include <vector>
+#include <type_traits>
+#include <source_location>
 #include <cstdint>
 
 enum LoadTag : uint32_t {
@@ -35,7 +71,21 @@ enum LoadTag : uint32_t {
 
 //Add a function to an internal list of loading functions:
 // (only call *before* "call_load_functions()")
-void add_load_function(LoadTag tag, std::function< void() > const &fn);
+// ('owner' is what other load functions name to wait for this one; 'where' names it in the startup trace)
+void add_load_function(LoadTag tag, std::function< void() > const &fn,
+	void const *owner = nullptr, std::source_location where = std::source_location::current());
+
+//Add a two-part loading function: 'read' is called on a worker thread, then
+// 'upload' is called on the main thread once 'read' is done and the load
+// functions of everything in 'after' (or, if it is empty, of every earlier tag) have finished:
+void add_load_function(LoadTag tag, std::function< void() > const &read, std::function< void() > const &upload,
+	std::vector< void const * > const &after, void const *owner, std::source_location where);
+
+//Add a two-part loading function whose first part, 'submit', is called on the main thread before the main-thread
+// part of any other load function, and whose second part, 'finish', is called (also on the main thread) at the usual point for 'tag':
+struct LoadSubmitFirst { };
+void add_load_function(LoadTag tag, LoadSubmitFirst, std::function< void() > const &submit, std::function< void() > const &finish,
+	void const *owner, std::source_location where);
 
 //Call all loading functions:
 // (loading functions may throw exceptions if they fail.)
@@ -50,13 +100,49 @@ T const *new_T() { return new T; }
 template< typename T >
 struct Load {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >) : value(nullptr) {
+	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >,
+		std::source_location where = std::source_location::current()) : value(nullptr) {
 		add_load_function(tag, [this,load_fn](){
 			this->value = load_fn();
 			if (!(this->value)) {
 				throw std::runtime_error("Loading failed.");
 			}
-		});
+		}, this, where);
+	}
+
+	//..or, split in two: 'read()' is called on a worker thread and its result passed to 'upload()' on the main thread.
+	// 'after' lists the Load<>s that 'upload' uses:
+	template< typename Read, typename Upload >
+	Load(LoadTag tag, Read const &read, Upload const &upload, std::vector< void const * > const &after = {},
+		std::source_location where = std::source_location::current()) : value(nullptr) {
+		using Result = std::invoke_result_t< Read const & >;
+		auto result = std::make_shared< std::optional< Result > >();
+		add_load_function(tag, [result,read](){
+			result->emplace(read());
+		}, [this,result,upload](){
+			this->value = upload(std::move(**result));
+			result->reset();
+			if (!(this->value)) {
+				throw std::runtime_error("Loading failed.");
+			}
+		}, after, this, where);
+	}
+
+	//..or with 'submit()' called before everything else on the main thread and its result passed to 'finish()' later:
+	template< typename Submit, typename Finish >
+	Load(LoadTag tag, LoadSubmitFirst, Submit const &submit, Finish const &finish,
+		std::source_location where = std::source_location::current()) : value(nullptr) {
+		using Result = std::invoke_result_t< Submit const & >;
+		auto result = std::make_shared< std::optional< Result > >();
+		add_load_function(tag, LoadSubmitFirst(), [result,submit](){
+			result->emplace(submit());
+		}, [this,result,finish](){
+			this->value = finish(std::move(**result));
+			result->reset();
+			if (!(this->value)) {
+				throw std::runtime_error("Loading failed.");
+			}
+		}, this, where);
 	}
 
 	//Make a "Load< T >" behave like a "T const *":
@@ -74,8 +160,9 @@ struct Load {
 template< >
 struct Load< void > {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load( LoadTag tag, const std::function< void() > &load_fn) {
-		add_load_function(tag, load_fn);
+	Load( LoadTag tag, const std::function< void() > &load_fn,
+		std::source_location where = std::source_location::current()) {
+		add_load_function(tag, load_fn, this, where);
 	}
 };
 
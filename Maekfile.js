@@ -154,10 +154,11 @@ const client_names = [
 	maek.CPP('PlayMode.cpp'),
 	maek.CPP('LitColorTextureProgram.cpp'),
 	maek.CPP('ColorTextureProgram.cpp'),  //not used right now, but you might want it
+	maek.CPP('SDFTextProgram.cpp'),
+	maek.CPP('DrawBatch.cpp'),
 	maek.CPP('TextMeshNovice.hpp'),
-	maek.CPP('Sound.cpp'),
-	maek.CPP('load_wav.cpp'),
-	maek.CPP('load_opus.cpp')
+	maek.CPP('GlyphAtlas.cpp'),
+	maek.CPP('Sound.cpp')
 ];
 
 const server_names = [
@@ -166,22 +167,40 @@ const server_names = [
 
 const common_names = [
 	maek.CPP('Game.cpp'),
+	maek.CPP('MessageDispatch.cpp'),
+	maek.CPP('compress_lz4.cpp'),
 	maek.CPP('data_path.cpp'),
 	maek.CPP('PathFont.cpp'),
 	maek.CPP('PathFont-font.cpp'),
 	maek.CPP('DrawLines.cpp'),
 	maek.CPP('ColorProgram.cpp'),
 	maek.CPP('Scene.cpp'),
+	maek.CPP('StreamRing.cpp'),
+	maek.CPP('transform_batch.cpp'),
+	maek.CPP('Frustum.cpp'),
+	maek.CPP('BVH.cpp'),
 	maek.CPP('Mesh.cpp'),
+	maek.CPP('MappedFile.cpp'),
+	maek.CPP('AssetPack.cpp'),
+	maek.CPP('asset_cache.cpp'),
 	maek.CPP('load_save_png.cpp'),
 	maek.CPP('gl_compile_program.cpp'),
 	maek.CPP('Mode.cpp'),
 	maek.CPP('GL.cpp'),
+	maek.CPP('gl_indirect.cpp'),
 	maek.CPP('Load.cpp'),
+	maek.CPP('Residency.cpp'),
 	maek.CPP('Connection.cpp'),
+	maek.CPP('IOUringEngine.cpp'),
 	maek.CPP('hex_dump.cpp')
 ];
 
+//(audio loaders are used by both the client and asset-cache-bench)
+const audio_loader_names = [
+	maek.CPP('load_wav.cpp'),
+	maek.CPP('load_opus.cpp')
+];
+
 const show_meshes_names = [
 	maek.CPP('show-meshes.cpp'),
 	maek.CPP('ShowMeshesProgram.cpp'),
@@ -194,17 +213,75 @@ const show_scene_names = [
 	maek.CPP('ShowSceneMode.cpp')
 ];
 
+const pack_assets_names = [
+	maek.CPP('pack-assets.cpp')
+];
+
+//benchmark tools -- not built by default; build with e.g. 'node Maekfile.js bench/connect-storm':
+const connect_storm_names = [
+	maek.CPP('connect-storm.cpp')
+];
+
+const net_bench_names = [
+	maek.CPP('net-bench.cpp')
+];
+
+const snapshot_bench_names = [
+	maek.CPP('snapshot-bench.cpp')
+];
+
+const transform_bench_names = [
+	maek.CPP('transform-bench.cpp')
+];
+
+const bvh_bench_names = [
+	maek.CPP('bvh-bench.cpp')
+];
+
+const asset_cache_bench_names = [
+	maek.CPP('asset-cache-bench.cpp')
+];
+
+const residency_bench_names = [
+	maek.CPP('residency-bench.cpp')
+];
+
 //the '[exeFile =] LINK(objFiles, exeFileBase, [, options])' links an array of objects into an executable:
 // objFiles: array of objects to link
 // exeFileBase: name of executable file to produce
 //returns exeFile: exeFileBase + a platform-dependant suffix (e.g., '.exe' on windows)
-const client_exe = maek.LINK([...client_names, ...common_names], 'dist/client');
+const client_exe = maek.LINK([...client_names, ...audio_loader_names, ...common_names], 'dist/client');
 const server_exe = maek.LINK([...server_names, ...common_names], 'dist/server');
 const show_meshes_exe = maek.LINK([...show_meshes_names, ...common_names], 'scenes/show-meshes');
 const show_scene_exe = maek.LINK([...show_scene_names, ...common_names], 'scenes/show-scene');
+const pack_assets_exe = maek.LINK([...pack_assets_names, ...common_names], 'scenes/pack-assets');
+const connect_storm_exe = maek.LINK([...connect_storm_names, ...common_names], 'bench/connect-storm');
+const net_bench_exe = maek.LINK([...net_bench_names, ...common_names], 'bench/net-bench');
+const snapshot_bench_exe = maek.LINK([...snapshot_bench_names, ...common_names], 'bench/snapshot-bench');
+const transform_bench_exe = maek.LINK([...transform_bench_names, ...common_names], 'bench/transform-bench');
+const bvh_bench_exe = maek.LINK([...bvh_bench_names, ...common_names], 'bench/bvh-bench');
+const asset_cache_bench_exe = maek.LINK([...asset_cache_bench_names, ...audio_loader_names, ...common_names], 'bench/asset-cache-bench');
+const residency_bench_exe = maek.LINK([...residency_bench_names, ...common_names], 'bench/residency-bench');
+
+//the '[outputs =] RUN(command, depends, outputs [, options])' runs a command to make files:
+// command: array of program + arguments (program may be an exeFile from LINK)
+// depends: array of files the command reads
+// outputs: array of files the command writes
+//returns outputs
+
+//pack the game's assets into one file (see AssetPack.hpp); the client reads from it before looking for loose files.
+// This lists exactly the files the client opens. The exception is quick_tug.pnct (the meshes PlayMode loads):
+// it is exported from scenes/quick_tug.blend by Blender, not built by Maek and not checked in, so
+// a dependency on it would break the default build. Until it gets an export rule, the client
+// loads it as a loose file from dist/.
+const packed_assets = [
+	'dist/quick_tug.scene',
+	'dist/HammersmithOne-Regular.ttf'
+];
+const assets_pack = maek.RUN([pack_assets_exe, 'dist/assets.pack', 'dist', ...packed_assets], packed_assets, ['dist/assets.pack']);
 
 //set the default target to the game (and copy the readme files):
-maek.TARGETS = [client_exe, server_exe, show_meshes_exe, show_scene_exe, ...copies];
+maek.TARGETS = [client_exe, server_exe, show_meshes_exe, show_scene_exe, ...assets_pack, ...copies];
 
 //Note that tasks that produce ':abstract targets' are never cached.
 // This is similar to how .PHONY targets behave in make.
@@ -469,6 +546,45 @@ function init_maek() {
 	};
 
 
+	//maek.RUN runs a command (e.g., a tool built with LINK) that makes some files:
+	// command is an array: the program (which may itself be a target) and its arguments
+	// depends is an array of files the command reads (besides the program)
+	// outputs is an array of files the command writes
+	//returns outputs
+	maek.RUN = (command, depends, outputs, localOptions = {}) => {
+		const options = combineOptions(localOptions);
+
+		//run() looks programs up on the PATH, so refer to built ones by absolute path:
+		const exe = (command[0] in maek.tasks ? path.resolve(command[0]) : command[0]);
+		const runCommand = [exe, ...command.slice(1)];
+
+		const task = async () => {
+			for (const output of outputs) {
+				await fsPromises.mkdir(path.dirname(output), { recursive: true });
+			}
+			await run(runCommand, `${task.label}: run`,
+				async () => {
+					return {
+						read:[...depends],
+						written:[...outputs]
+					};
+				}
+			);
+		};
+
+		task.depends = [command[0], ...depends, ...options.depends];
+		task.label = `RUN ${outputs.join(', ')}`;
+
+		for (const output of outputs) {
+			if (output in maek.tasks) {
+				throw new Error(`Task ${task.label} purports to create ${output}, but ${maek.tasks[output].label} already creates that file.`);
+			}
+			maek.tasks[output] = task;
+		}
+
+		return outputs;
+	};
+
 	//says something went wrong in building -- should fail loudly:
 	class BuildError extends Error {
 		constructor(message) {
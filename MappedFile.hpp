@@ -0,0 +1,113 @@
+#pragma once
+
+/*
+ * A MappedFile maps a whole file into memory (read-only), so its contents
+ *  can be used straight out of the OS's page cache -- e.g., passed directly
+ *  to glBufferData -- instead of being read into temporary buffers first.
+ *
+ * read_chunk() walks the file's chunks in order (same format as read_chunk()
+ *  in read_write_chunk.hpp) and returns views of their contents, after
+ *  checking that each chunk is in bounds and the right size for its type.
+ *
+ * Chunk contents that aren't aligned for their type (e.g., data following a
+ *  string chunk whose length isn't a multiple of four) are copied into
+ *  storage owned by the MappedFile instead. (The exporters in scenes/ pad
+ *  their string chunks so this doesn't happen.)
+ *
+ * If there is an asset pack (see AssetPack.hpp) that contains 'filename',
+ *  the MappedFile views the packed copy instead of opening the file.
+ *
+ * Spans returned by read_chunk() are valid as long as the MappedFile is.
+ *
+ * Example:
+ *   MappedFile file(data_path("level.pnct"));
+ *   std::span< Vertex const > vertices = file.read_chunk< Vertex >("pnct");
+ */
+
+#include <span>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+struct MappedFile {
+	//map a file (or view its copy in the asset pack); throws if it can't be opened or mapped:
+	MappedFile(std::string const &filename);
+	//..always from the file itself:
+	struct FileOnly { };
+	MappedFile(std::string const &filename, FileOnly);
+	//..or read chunks from bytes already in memory ('filename' is just for messages):
+	MappedFile(std::string const &filename, std::vector< uint8_t > &&bytes);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	//view the contents of the next chunk, which must have the given magic number:
+	// throws if the chunk is missing, truncated, or not a whole number of T's
+	template< typename T >
+	std::span< T const > read_chunk(std::string const &magic);
+
+	//has every chunk been read?
+	bool at_end() const { return offset == size; }
+
+	std::string filename;
+	char const *data = nullptr;
+	size_t size = 0;
+	size_t offset = 0; //start of the next chunk
+
+	//internals:
+	std::vector< std::unique_ptr< std::max_align_t[] > > copies; //misaligned chunks, copied
+	std::vector< uint8_t > owned; //contents, if held in memory rather than mapped
+	bool mapped = false; //does the destructor need to unmap 'data'?
+	void map_file();
+	#if defined(_WIN32)
+	void *file_handle = nullptr;
+	void *mapping_handle = nullptr;
+	#endif
+};
+
+template< typename T >
+std::span< T const > MappedFile::read_chunk(std::string const &magic) {
+	static_assert(std::is_trivially_copyable_v< T >, "chunk contents are used directly from the file, so must be plain data");
+	static_assert(alignof(T) <= alignof(std::max_align_t), "copies of misaligned chunks can't be aligned for T");
+
+	struct ChunkHeader {
+		char magic[4];
+		uint32_t size;
+	};
+	static_assert(sizeof(ChunkHeader) == 8, "header is packed");
+
+	if (size - offset < sizeof(ChunkHeader)) {
+		throw std::runtime_error("Failed to read chunk header ('" + magic + "' in '" + filename + "')");
+	}
+	ChunkHeader header;
+	std::memcpy(&header, data + offset, sizeof(header));
+	if (std::string(header.magic, 4) != magic) {
+		throw std::runtime_error("Unexpected magic number in chunk (wanted '" + magic + "' in '" + filename + "')");
+	}
+	if (header.size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size ('" + magic + "' in '" + filename + "')");
+	}
+	if (size - offset - sizeof(ChunkHeader) < header.size) {
+		throw std::runtime_error("Failed to read chunk data ('" + magic + "' in '" + filename + "')");
+	}
+
+	char const *begin = data + offset + sizeof(ChunkHeader);
+	offset += sizeof(ChunkHeader) + header.size;
+
+	size_t count = header.size / sizeof(T);
+	if (count == 0) return std::span< T const >();
+
+	if (reinterpret_cast< uintptr_t >(begin) % alignof(T) != 0) {
+		size_t words = (header.size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		copies.emplace_back(new std::max_align_t[words]);
+		std::memcpy(copies.back().get(), begin, header.size);
+		begin = reinterpret_cast< char const * >(copies.back().get());
+	}
+	return std::span< T const >(reinterpret_cast< T const * >(begin), count);
+}
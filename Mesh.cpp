@@ -1,20 +1,24 @@
 #include "Mesh.hpp"
-#include "read_write_chunk.hpp"
+#include "MappedFile.hpp"
+#include "InstanceAttributes.hpp"
 
 #include <glm/glm.hpp>
 
 #include <stdexcept>
-#include <fstream>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <set>
 #include <cstddef>
 
-MeshBuffer::MeshBuffer(std::string const &filename) {
-	glGenBuffers(1, &buffer);
+MeshBuffer::MeshBuffer(std::string const &filename) : MeshBuffer(filename, Deferred()) {
+	upload();
+}
 
-	std::ifstream file(filename, std::ios::binary);
+MeshBuffer::MeshBuffer(std::string const &filename, Deferred) {
+	//(chunk contents are used -- and, in upload(), uploaded -- straight from the mapped file, without intermediate copies)
+	pending_file = std::make_shared< MappedFile >(filename);
+	MappedFile &file = *pending_file;
 
 	GLuint total = 0;
 
@@ -25,16 +29,25 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		glm::vec2 TexCoord;
 	};
 	static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
-	std::vector< Vertex > data;
 
-	//read + upload data chunk:
-	if (filename.size() >= 5 && filename.substr(filename.size()-5) == ".pnct") {
-		read_chunk(file, "pnct", &data);
+	//quantized vertex used by indexed files:
+	struct IndexedVertex {
+		glm::vec3 Position;
+		int16_t Normal[4]; //snorm16 (w is padding)
+		glm::u8vec4 Color;
+		uint16_t TexCoord[2]; //half-float (texcoords can go outside [0,1], so unorm would need a per-mesh scale)
+	};
+	static_assert(sizeof(IndexedVertex) == 3*4+4*2+4*1+2*2, "IndexedVertex is packed.");
 
-		//upload data:
-		glBindBuffer(GL_ARRAY_BUFFER, buffer);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(Vertex), data.data(), GL_STATIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	std::span< Vertex const > data;
+	std::span< IndexedVertex const > indexed_data;
+	std::span< uint32_t const > indices;
+
+	//read data chunk (and, for indexed files, element indices):
+	bool indexed = false;
+	if (filename.size() >= 5 && filename.substr(filename.size()-5) == ".pnct") {
+		data = file.read_chunk< Vertex >("pnct");
+		pending_vertices = std::as_bytes(data);
 
 		total = GLuint(data.size()); //store total for later checks on index
 
@@ -43,22 +56,45 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		Normal = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Normal));
 		Color = Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), offsetof(Vertex, Color));
 		TexCoord = Attrib(2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, TexCoord));
+	} else if (filename.size() >= 6 && filename.substr(filename.size()-6) == ".ipnct") {
+		indexed = true;
+
+		indexed_data = file.read_chunk< IndexedVertex >("ipnc");
+		indices = file.read_chunk< uint32_t >("ind0");
+
+		total = GLuint(indices.size());
+		for (uint32_t i : indices) {
+			if (i >= indexed_data.size()) throw std::runtime_error("mesh file '" + filename + "' contains out-of-range vertex index");
+		}
+
+		pending_vertices = std::as_bytes(indexed_data);
+		pending_indices = std::as_bytes(indices);
+
+		//store attrib locations:
+		Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(IndexedVertex), offsetof(IndexedVertex, Position));
+		Normal = Attrib(3, GL_SHORT, GL_TRUE, sizeof(IndexedVertex), offsetof(IndexedVertex, Normal));
+		Color = Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(IndexedVertex), offsetof(IndexedVertex, Color));
+		TexCoord = Attrib(2, GL_HALF_FLOAT, GL_FALSE, sizeof(IndexedVertex), offsetof(IndexedVertex, TexCoord));
 	} else {
 		throw std::runtime_error("Unknown file type '" + filename + "'");
 	}
 
-	std::vector< char > strings;
-	read_chunk(file, "str0", &strings);
+	//position of the i'th vertex drawn (for computing bounds):
+	auto position = [&](uint32_t i) -> glm::vec3 const & {
+		return (indexed ? indexed_data[indices[i]].Position : data[i].Position);
+	};
+
+	std::span< char const > strings = file.read_chunk< char >("str0");
 
 	{ //read index chunk, add to meshes:
+		//(for indexed files, vertex_begin/vertex_end are a range of indices)
 		struct IndexEntry {
 			uint32_t name_begin, name_end;
 			uint32_t vertex_begin, vertex_end;
 		};
 		static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
 
-		std::vector< IndexEntry > index;
-		read_chunk(file, "idx0", &index);
+		std::span< IndexEntry const > index = file.read_chunk< IndexEntry >("idx0");
 
 		for (auto const &entry : index) {
 			if (!(entry.name_begin <= entry.name_end && entry.name_end <= strings.size())) {
@@ -67,14 +103,15 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 			if (!(entry.vertex_begin <= entry.vertex_end && entry.vertex_end <= total)) {
 				throw std::runtime_error("index entry has out-of-range vertex start/count");
 			}
-			std::string name(&strings[0] + entry.name_begin, &strings[0] + entry.name_end);
+			std::string name(strings.data() + entry.name_begin, strings.data() + entry.name_end);
 			Mesh mesh;
 			mesh.type = GL_TRIANGLES;
 			mesh.start = entry.vertex_begin;
 			mesh.count = entry.vertex_end - entry.vertex_begin;
+			mesh.index_type = (indexed ? GL_UNSIGNED_INT : GL_NONE);
 			for (uint32_t v = entry.vertex_begin; v < entry.vertex_end; ++v) {
-				mesh.min = glm::min(mesh.min, data[v].Position);
-				mesh.max = glm::max(mesh.max, data[v].Position);
+				mesh.min = glm::min(mesh.min, position(v));
+				mesh.max = glm::max(mesh.max, position(v));
 			}
 			bool inserted = meshes.insert(std::make_pair(name, mesh)).second;
 			if (!inserted) {
@@ -83,7 +120,7 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		}
 	}
 
-	if (file.peek() != EOF) {
+	if (!file.at_end()) {
 		std::cerr << "WARNING: trailing data in mesh file '" << filename << "'" << std::endl;
 	}
 
@@ -98,6 +135,41 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 	*/
 }
 
+void MeshBuffer::upload() {
+	if (!pending_file) return; //already uploaded
+
+	bytes = pending_vertices.size() + pending_indices.size();
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, pending_vertices.size(), pending_vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!pending_indices.empty()) {
+		glGenBuffers(1, &index_buffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, pending_indices.size(), pending_indices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+
+	//done with the file:
+	pending_vertices = std::span< std::byte const >();
+	pending_indices = std::span< std::byte const >();
+	pending_file.reset();
+}
+
+void MeshBuffer::unload() {
+	if (buffer != 0) {
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+	if (index_buffer != 0) {
+		glDeleteBuffers(1, &index_buffer);
+		index_buffer = 0;
+	}
+	bytes = 0;
+}
+
 const Mesh &MeshBuffer::lookup(std::string const &name) const {
 	auto f = meshes.find(name);
 	if (f == meshes.end()) {
@@ -107,6 +179,10 @@ const Mesh &MeshBuffer::lookup(std::string const &name) const {
 }
 
 GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
+	return make_vao_for_program(program, 0);
+}
+
+GLuint MeshBuffer::make_vao_for_program(GLuint program, GLuint instance_buffer) const {
 	//create a new vertex array object:
 	GLuint vao = 0;
 	glGenVertexArrays(1, &vao);
@@ -128,6 +204,30 @@ GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
 	bind_attribute("Color", Color);
 	bind_attribute("TexCoord", TexCoord);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//(the element array binding is part of the vertex array object's state)
+	if (index_buffer != 0) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+	}
+
+	//Matrix attributes take one location per column, and advance once per instance:
+	if (instance_buffer != 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+		auto bind_instance_attribute = [&](char const *name, GLint rows, GLint columns, size_t offset) {
+			GLint location = glGetAttribLocation(program, name);
+			if (location == -1) return; //can't bind missing attribs
+			for (GLint c = 0; c < columns; ++c) {
+				glVertexAttribPointer(location + c, rows, GL_FLOAT, GL_FALSE, sizeof(InstanceAttributes), (GLbyte *)0 + offset + c * rows * sizeof(float));
+				glEnableVertexAttribArray(location + c);
+				glVertexAttribDivisor(location + c, 1);
+			}
+			bound.insert(location);
+		};
+		bind_instance_attribute("CLIP_FROM_OBJECT", 4, 4, offsetof(InstanceAttributes, clip_from_object));
+		bind_instance_attribute("LIGHT_FROM_OBJECT", 3, 4, offsetof(InstanceAttributes, light_from_object));
+		bind_instance_attribute("LIGHT_FROM_NORMAL", 3, 3, offsetof(InstanceAttributes, light_from_normal));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 	glBindVertexArray(0);
 
 	//Check that all active attributes were bound:
@@ -7,21 +7,33 @@
  *  a single OpenGL array buffer. Individual meshes can be looked up by name
  *  using the MeshBuffer::lookup() function.
  *
+ * Two file formats are supported (both written by scenes/export-meshes.py):
+ *  .pnct -- triangle soup; 48 bytes per vertex, no sharing
+ *  .ipnct -- indexed; shared vertices stored once (28 bytes each, with
+ *            quantized normals and texcoords) and triangles ordered for the
+ *            GPU's post-transform vertex cache. Meshes are ranges of indices.
+ *
  */
 
 #include "GL.hpp"
 #include <glm/glm.hpp>
 #include <map>
+#include <span>
 #include <limits>
+#include <memory>
 #include <string>
+#include <cstddef>
+
+struct MappedFile;
 
 
 struct Mesh {
 	//Meshes are vertex ranges (and primitive types) in their MeshBuffer:
 
 	GLenum type = GL_TRIANGLES; //type of primitives in mesh
-	GLuint start = 0; //index of first vertex
-	GLuint count = 0; //count of vertices
+	GLuint start = 0; //index of first vertex (or first index, if index_type isn't GL_NONE)
+	GLuint count = 0; //count of vertices (or indices)
+	GLenum index_type = GL_NONE; //type of indices in the buffer's element array (GL_NONE for non-indexed meshes)
 
 	//Bounding box.
 	//useful for debug visualization and (perhaps, eventually) collision detection:
@@ -34,6 +46,17 @@ struct MeshBuffer {
 	// note: will throw if file fails to read.
 	MeshBuffer(std::string const &filename);
 
+	//..in two steps, for loading on a worker thread (see Load.hpp):
+	// the 'Deferred' constructor reads and checks the file but makes no GL calls;
+	// upload() must then be called on the GL thread before 'buffer' is used
+	struct Deferred { };
+	MeshBuffer(std::string const &filename, Deferred);
+	void upload();
+
+	//free 'buffer' and 'index_buffer' (e.g., as the 'unload' of a Resident< MeshBuffer >; see Residency.hpp):
+	// note: vaos made by make_vao_for_program belong to the caller, so delete those first
+	void unload();
+
 	//look up a particular mesh by name:
 	// note: will throw if mesh not found.
 	const Mesh &lookup(std::string const &name) const;
@@ -42,14 +65,26 @@ struct MeshBuffer {
 	// note: will throw if program defines attributes not contained in this buffer
 	GLuint make_vao_for_program(GLuint program) const;
 
+	//..for an instanced program (see Scene::Drawable::Pipeline::instanced), which also reads
+	// CLIP_FROM_OBJECT, LIGHT_FROM_OBJECT, and LIGHT_FROM_NORMAL per-instance from 'instance_buffer' (laid out as InstanceAttributes):
+	GLuint make_vao_for_program(GLuint program, GLuint instance_buffer) const;
+
 	//This is the OpenGL vertex buffer object containing the mesh data:
 	GLuint buffer = 0;
+	//..and, for indexed files, the element buffer (bound in vaos made by make_vao_for_program):
+	GLuint index_buffer = 0;
+	//size of the data in those buffers (e.g., for Residency budgets):
+	size_t bytes = 0;
 
 	//-- internals ---
 
 	//used by the lookup() function:
 	std::map< std::string, Mesh > meshes;
 
+	//file contents waiting for upload():
+	std::shared_ptr< MappedFile > pending_file;
+	std::span< std::byte const > pending_vertices, pending_indices;
+
 	//These 'Attrib' structures describe the location of various attributes within the buffer (in exactly format wanted by glVertexAttribPointer). They are set when the file is loaded and are used by the "make_vao_for_program" call:
 	struct Attrib {
 		GLint size = 0;
@@ -0,0 +1,52 @@
+#include "MessageDispatch.hpp"
+
+#include "Connection.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+void MessageDispatch::on(Message type, uint32_t min_size, uint32_t max_size, Handler const &handler) {
+	assert(min_size <= max_size && max_size <= 0xffffff); //(size field is 24 bits)
+	Entry &entry = entries[uint8_t(type)];
+	entry.handler = handler;
+	entry.min_size = min_size;
+	entry.max_size = max_size;
+}
+
+uint32_t MessageDispatch::dispatch(Connection *connection_) const {
+	assert(connection_);
+	auto &connection = *connection_;
+	auto &recv_buffer = connection.recv_buffer;
+
+	uint32_t handled = 0;
+	size_t at = 0; //start of the next message's header
+	while (connection && recv_buffer.size() - at >= HeaderSize) {
+		uint8_t const *header = recv_buffer.data() + at;
+
+		Entry const &entry = entries[header[0]];
+		if (!entry.handler) {
+			throw std::runtime_error("Message with unknown type " + std::to_string(int(header[0])) + ".");
+		}
+
+		uint32_t size = (uint32_t(header[3]) << 16)
+		              | (uint32_t(header[2]) << 8)
+		              |  uint32_t(header[1]);
+		if (size < entry.min_size || size > entry.max_size) {
+			throw std::runtime_error("Message of type " + std::to_string(int(header[0])) + " with size " + std::to_string(size)
+				+ " outside of [" + std::to_string(entry.min_size) + ", " + std::to_string(entry.max_size) + "].");
+		}
+
+		//expecting complete message:
+		if (recv_buffer.size() - at < HeaderSize + size) break;
+
+		entry.handler(connection_, std::span< uint8_t const >(header + HeaderSize, size));
+		at += HeaderSize + size;
+		handled += 1;
+	}
+
+	//delete all handled messages from buffer at once:
+	recv_buffer.erase(recv_buffer.begin(), recv_buffer.begin() + at);
+
+	return handled;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+ * MessageDispatch parses the [type, size_low0, size_mid8, size_high8] framing
+ *  used by every message in Game.hpp and hands each complete message's payload
+ *  to the handler registered for its type.
+ *
+ * Payloads are passed as spans pointing directly into the connection's
+ *  recv_buffer (no copies); all handled messages are removed from the buffer
+ *  with a single erase once the batch is done.
+ *
+ * Example:
+ *   MessageDispatch dispatch;
+ *   dispatch.on(Message::C2S_Controls, 5, 5, [&](Connection *c, std::span< uint8_t const > payload) {
+ *       ...
+ *   });
+ *   ...
+ *   //in the OnRecv callback:
+ *   dispatch.dispatch(c); //throws on unknown / malformed messages
+ */
+
+#include "Game.hpp"
+
+#include <array>
+#include <span>
+#include <functional>
+#include <cstdint>
+
+struct Connection;
+
+struct MessageDispatch {
+	//handlers get the connection and the message payload (header not included).
+	// the payload points into connection->recv_buffer, so it is only valid during the call,
+	// and handlers must not modify recv_buffer (they may close the connection or send, though).
+	using Handler = std::function< void(Connection *, std::span< uint8_t const > payload) >;
+
+	//register a handler for 'type'; payload sizes outside [min_size, max_size] are rejected
+	// as soon as the header arrives (without waiting for the payload):
+	void on(Message type, uint32_t min_size, uint32_t max_size, Handler const &handler);
+
+	//handle every complete message at the front of connection->recv_buffer:
+	// returns the number of messages handled (incomplete messages are left for next time)
+	// throws on a message with no handler or an out-of-range size
+	uint32_t dispatch(Connection *connection) const;
+
+	//message header size, in bytes:
+	static constexpr uint32_t HeaderSize = 4;
+
+	//internals:
+	struct Entry {
+		Handler handler; //(empty if no handler registered)
+		uint32_t min_size = 0;
+		uint32_t max_size = 0;
+	};
+	std::array< Entry, 256 > entries; //indexed by uint8_t(Message)
+};
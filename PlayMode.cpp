@@ -4,6 +4,7 @@
 #include "ColorTextureProgram.hpp"
 
 #include "DrawLines.hpp"
+#include "DrawBatch.hpp"
 #include "Mesh.hpp"
 #include "gl_errors.hpp"
 #include "data_path.hpp"
@@ -23,14 +24,31 @@
  * Scene loading code based on starter code from Game2 onwards
  **************************************************************/
 GLuint quicktug_meshes_for_lit_color_texture_program = 0;
-Load< MeshBuffer > quicktug_meshes(LoadTagDefault, []() -> MeshBuffer const * {
-	MeshBuffer const *ret = new MeshBuffer(data_path("quick_tug.pnct"));
+GLuint quicktug_meshes_for_lit_color_texture_program_instanced = 0;
+Load< MeshBuffer > quicktug_meshes(LoadTagDefault, []() {
+	return std::make_unique< MeshBuffer >(data_path("quick_tug.pnct"), MeshBuffer::Deferred());
+}, [](std::unique_ptr< MeshBuffer > &&ret) -> MeshBuffer const * {
+	ret->upload();
 	quicktug_meshes_for_lit_color_texture_program = ret->make_vao_for_program(lit_color_texture_program->program);
+	quicktug_meshes_for_lit_color_texture_program_instanced = ret->make_vao_for_program(lit_color_texture_program_instanced->program, lit_color_texture_program_instanced->instance_buffer);
+	return ret.release();
+}, { &lit_color_texture_program, &lit_color_texture_program_instanced });
+
+//scene file as read on a loading thread; drawables get made once quicktug_meshes is loaded:
+struct QuicktugSceneFile {
+	std::unique_ptr< Scene > scene;
+	std::vector< std::pair< uint32_t, std::string > > meshes; //(transform, mesh name)
+};
+
+Load< Scene > quicktug_scene(LoadTagDefault, []() {
+	QuicktugSceneFile ret;
+	ret.scene = std::make_unique< Scene >(data_path("quick_tug.scene"), [&](Scene &, uint32_t transform, std::string const &mesh_name){
+		ret.meshes.emplace_back(transform, mesh_name);
+	});
 	return ret;
-});
-
-Load< Scene > quicktug_scene(LoadTagDefault, []() -> Scene const * {
-	return new Scene(data_path("quick_tug.scene"), [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
+}, [](QuicktugSceneFile &&file) -> Scene const * {
+	Scene &scene = *file.scene;
+	for (auto const &[transform, mesh_name] : file.meshes) {
 		Mesh const &mesh = quicktug_meshes->lookup(mesh_name);
 
 		scene.drawables.emplace_back(transform);
@@ -39,12 +57,17 @@ Load< Scene > quicktug_scene(LoadTagDefault, []() -> Scene const * {
 		drawable.pipeline = lit_color_texture_program_pipeline;
 
 		drawable.pipeline.vao = quicktug_meshes_for_lit_color_texture_program;
+		drawable.pipeline.instanced.vao = quicktug_meshes_for_lit_color_texture_program_instanced;
 		drawable.pipeline.type = mesh.type;
 		drawable.pipeline.start = mesh.start;
 		drawable.pipeline.count = mesh.count;
+		drawable.pipeline.index_type = mesh.index_type;
 
-	});
-});
+		drawable.min = mesh.min;
+		drawable.max = mesh.max;
+	}
+	return file.scene.release();
+}, { &quicktug_meshes });
 
 /***********************************
  * Scene copying code based on
@@ -55,47 +78,54 @@ PlayMode::PlayMode(Client &client_) : identifier_text("YOU!"),
 									  play_again_text("Press ENTER or SPACE to play again!"),
 									  tug_clock_text("0"),
 									  scene(*quicktug_scene), client(client_) {
+	//state messages from the server can be compressed:
+	Game::send_compression_message(&client.connection);
+
 	/* DEBUG */
-	for (auto &transform : scene.transforms) {
-		if (transform.name == "Rope") rope = &transform;
-		else if (transform.name == "P1") p1_hands = &transform;
-		else if (transform.name == "P2") p2_hands = &transform;
-		else if (transform.name == "P1LightOff") p1_light_off = &transform;
-		else if (transform.name == "P1LightOn") p1_light_on = &transform;
-		else if (transform.name == "P2LightOff") p2_light_off = &transform;
-		else if (transform.name == "P2LightOn") p2_light_on = &transform;
-		else if (transform.name == "EmptyBox") empty_box = &transform;
-		else if (transform.name == "TriggerBox") trigger_box = &transform;
-		else if (transform.name == "AdvantageP1Box") adv_box_p1 = &transform;
-		else if (transform.name == "AdvantageP2Box") adv_box_p2 = &transform;
-		else if (transform.name == "CounterBox") counter_box = &transform;
-		else if (transform.name == "Penalty1") penalty_x1 = &transform;
-		else if (transform.name == "Penalty2") penalty_x2 = &transform;
-		else if (transform.name == "P1Flag") p1_flag = &transform;
-		else if (transform.name == "P2Flag") p2_flag = &transform;
+	for (uint32_t i = 0; i < scene.transforms.size(); ++i) {
+		std::string const &name = scene.transforms.names[i];
+		if (name == "Rope") rope = scene.transform(i);
+		else if (name == "P1") p1_hands = scene.transform(i);
+		else if (name == "P2") p2_hands = scene.transform(i);
+		else if (name == "P1LightOff") p1_light_off = scene.transform(i);
+		else if (name == "P1LightOn") p1_light_on = scene.transform(i);
+		else if (name == "P2LightOff") p2_light_off = scene.transform(i);
+		else if (name == "P2LightOn") p2_light_on = scene.transform(i);
+		else if (name == "EmptyBox") empty_box = scene.transform(i);
+		else if (name == "TriggerBox") trigger_box = scene.transform(i);
+		else if (name == "AdvantageP1Box") adv_box_p1 = scene.transform(i);
+		else if (name == "AdvantageP2Box") adv_box_p2 = scene.transform(i);
+		else if (name == "CounterBox") counter_box = scene.transform(i);
+		else if (name == "Penalty1") penalty_x1 = scene.transform(i);
+		else if (name == "Penalty2") penalty_x2 = scene.transform(i);
+		else if (name == "P1Flag") p1_flag = scene.transform(i);
+		else if (name == "P2Flag") p2_flag = scene.transform(i);
 	}
 
-	if (rope == nullptr) throw std::runtime_error("Rope not found.");
-	if (p1_hands == nullptr) throw std::runtime_error("P1 Hands not found.");
-	if (p2_hands == nullptr) throw std::runtime_error("P2 Hands not found.");
-	if (p1_light_off == nullptr) throw std::runtime_error("P1 Light (Off) not found.");
-	if (p1_light_on == nullptr) throw std::runtime_error("P1 Light (On) not found.");
-	if (p2_light_off == nullptr) throw std::runtime_error("P2 Light (Off) not found.");
-	if (p2_light_on == nullptr) throw std::runtime_error("P2 Light (On) not found.");
-	if (empty_box == nullptr) throw std::runtime_error("Empty Box not found.");
-	if (trigger_box == nullptr) throw std::runtime_error("Trigger Box not found.");
-	if (adv_box_p1 == nullptr) throw std::runtime_error("P1 Advantage Box not found.");
-	if (adv_box_p2 == nullptr) throw std::runtime_error("P2 Advantage Box not found.");
-	if (counter_box == nullptr) throw std::runtime_error("Counter Box not found.");
-	if (penalty_x1 == nullptr) throw std::runtime_error("Penalty 1 not found.");
-	if (penalty_x2 == nullptr) throw std::runtime_error("Penalty 2 not found.");
-	if (p1_flag == nullptr) throw std::runtime_error("P1 Flag not found.");
-	if (p2_flag == nullptr) throw std::runtime_error("P2 Flag not found.");
+	if (!rope) throw std::runtime_error("Rope not found.");
+	if (!p1_hands) throw std::runtime_error("P1 Hands not found.");
+	if (!p2_hands) throw std::runtime_error("P2 Hands not found.");
+	if (!p1_light_off) throw std::runtime_error("P1 Light (Off) not found.");
+	if (!p1_light_on) throw std::runtime_error("P1 Light (On) not found.");
+	if (!p2_light_off) throw std::runtime_error("P2 Light (Off) not found.");
+	if (!p2_light_on) throw std::runtime_error("P2 Light (On) not found.");
+	if (!empty_box) throw std::runtime_error("Empty Box not found.");
+	if (!trigger_box) throw std::runtime_error("Trigger Box not found.");
+	if (!adv_box_p1) throw std::runtime_error("P1 Advantage Box not found.");
+	if (!adv_box_p2) throw std::runtime_error("P2 Advantage Box not found.");
+	if (!counter_box) throw std::runtime_error("Counter Box not found.");
+	if (!penalty_x1) throw std::runtime_error("Penalty 1 not found.");
+	if (!penalty_x2) throw std::runtime_error("Penalty 2 not found.");
+	if (!p1_flag) throw std::runtime_error("P1 Flag not found.");
+	if (!p2_flag) throw std::runtime_error("P2 Flag not found.");
 
 	//get pointer to camera for convenience:
 	if (scene.cameras.size() != 1) throw std::runtime_error("Expecting scene to have exactly one camera, but it has " + std::to_string(scene.cameras.size()));
 	camera = &scene.cameras.front();
 
+	//nothing in the game scene is blended, so draw order doesn't matter:
+	scene.sort_drawables = true;
+
 	// identifier_text = TextMeshNovice::TextMeshNovice("YOU!");
 	identifier_text.create_data_vector();
 	identifier_text.create_mesh(Mode::window, 0.0f, 0.0f, 0.2f, 0x00, 0x00, 0x00, 0xff);
@@ -112,6 +142,17 @@ PlayMode::~PlayMode() {
 
 bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
 
+	//no need for state updates while the window can't be seen:
+	if (evt.type == SDL_EVENT_WINDOW_MINIMIZED || evt.type == SDL_EVENT_WINDOW_HIDDEN
+	 || evt.type == SDL_EVENT_WINDOW_RESTORED || evt.type == SDL_EVENT_WINDOW_SHOWN) {
+		bool hidden = (evt.type == SDL_EVENT_WINDOW_MINIMIZED || evt.type == SDL_EVENT_WINDOW_HIDDEN);
+		if (hidden != paused_updates) {
+			paused_updates = hidden;
+			Game::send_pause_message(&client.connection, paused_updates);
+		}
+		return false;
+	}
+
 	if (evt.type == SDL_EVENT_KEY_DOWN) {
 		if (evt.key.repeat) {
 			//ignore repeats
@@ -236,9 +277,9 @@ void PlayMode::update(float elapsed) {
 
 		// Set trigger box and other models based on game state
 		float box_angle = 0.0f;
-		Scene::Transform *adv_box = nullptr;
-		Scene::Transform *adv_light = nullptr;
-		Scene::Transform *adv_off = nullptr;
+		Scene::Transform adv_box;
+		Scene::Transform adv_light;
+		Scene::Transform adv_off;
 		int adv_dir = 0;
 		switch (game.matchState) {
 			case Game::GameState::STANDBY:
@@ -282,9 +323,9 @@ void PlayMode::update(float elapsed) {
 						}
 					}
 				}
-				assert(adv_box != nullptr);
-				assert(adv_light != nullptr);
-				assert(adv_off != nullptr);
+				assert(adv_box);
+				assert(adv_light);
+				assert(adv_off);
 				assert(adv_dir != 0);
 
 				if (game.triggerDirection == Game::TriggerDirection::LEFT) box_angle = -90.0f;
@@ -333,12 +374,10 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 	 *********************************************/
 	camera->aspect = float(drawable_size.x) / float(drawable_size.y);
 
-	//set up light type and position for lit_color_texture_program:
-	glUseProgram(lit_color_texture_program->program);
-	glUniform1i(lit_color_texture_program->LIGHT_TYPE_int, 1);
-	glUniform3fv(lit_color_texture_program->LIGHT_DIRECTION_vec3, 1, glm::value_ptr(glm::vec3(0.0f, 0.0f,-1.0f)));
-	glUniform3fv(lit_color_texture_program->LIGHT_ENERGY_vec3, 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 0.95f)));
-	glUseProgram(0);
+	//set up light type and position for lit_color_texture_program (passed along by scene.draw in its 'Frame' uniform block):
+	scene.frame_uniforms.light_type = 1;
+	scene.frame_uniforms.light_direction = glm::vec3(0.0f, 0.0f,-1.0f);
+	scene.frame_uniforms.light_energy = glm::vec3(1.0f, 1.0f, 0.95f);
 
 	glClearColor(0.5f, 1.0f, 0.5f, 1.0f);
 	glClearDepth(1.0f); //1.0 is actually the default value to clear the depth buffer to, but FYI you can change it.
@@ -374,7 +413,9 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 	);
 	
 	{
-		// DrawLines lines(world_to_clip);
+		DrawBatch batch; //all of the overlay (text + lines) is drawn with a few calls when this goes out of scope
+
+		// DrawLines lines(world_to_clip, &batch);
 
 		// auto draw_text = [&](glm::vec2 const &at, std::string const &text, float H) {
 		// 	lines.draw_text(text,
@@ -404,7 +445,7 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 						identifier_text.set_position(Mode::window, you_text_clip.x, you_text_clip.y, 0.1f,
 																					0xff, 0x00, 0x00, 0xff);
 					}
-					identifier_text.draw_text_mesh();
+					identifier_text.draw_text_mesh(batch);
 				}
 				// draw_text(glm::vec2(0.0f, -0.1f + Game::PlayerRadius), player.name, 0.09f);
 			}
@@ -450,8 +491,8 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 				}
 			}
 			play_again_text.set_position(Mode::window, 0.0f, 0.1f, 0.1f, 0x00, 0x00, 0x00, 0xff);
-			victory_text.draw_text_mesh();
-			play_again_text.draw_text_mesh();
+			victory_text.draw_text_mesh(batch);
+			play_again_text.draw_text_mesh(batch);
 		}
 		else if (game.matchState != Game::GameState::STANDBY) {
 			glm::vec3 tug_clock_clip = glm::vec3(world_to_clip * glm::vec4(0.0f, BOX_HEIGHT - 1.5f, 0.0f, 1.0f));
@@ -475,7 +516,7 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 					lastTugClockTime = game.tugClockTimer;
 				}
 			}
-			tug_clock_text.draw_text_mesh();
+			tug_clock_text.draw_text_mesh(batch);
 		}
 
 		// DEBUG:
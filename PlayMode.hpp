@@ -38,26 +38,27 @@ struct PlayMode : Mode {
 
 	//connection to server:
 	Client &client;
+	bool paused_updates = false; //asked server to stop sending state (window hidden)
 
 	//3D Models, using blender world space (z axis is up!)
 	//anything that's not shown is pushed off screen, a la PPU466
-	Scene::Transform *rope = nullptr;
-	Scene::Transform *p1_hands = nullptr; 
-	Scene::Transform *p2_hands = nullptr;
-	Scene::Transform *p1_light_off = nullptr; // the light indicates who's pulling
-	Scene::Transform *p1_light_on = nullptr;
-	Scene::Transform *p2_light_off = nullptr;
-	Scene::Transform *p2_light_on = nullptr;
-	Scene::Transform *p1_flag = nullptr;
-	Scene::Transform *p2_flag = nullptr;
-
-	Scene::Transform *empty_box = nullptr;
-	Scene::Transform *trigger_box = nullptr; // default
-	Scene::Transform *adv_box_p1 = nullptr; // left player
-	Scene::Transform *adv_box_p2 = nullptr; // right player
-	Scene::Transform *counter_box = nullptr; // default
-	Scene::Transform *penalty_x1 = nullptr; // default
-	Scene::Transform *penalty_x2 = nullptr; // default
+	Scene::Transform rope;
+	Scene::Transform p1_hands; 
+	Scene::Transform p2_hands;
+	Scene::Transform p1_light_off; // the light indicates who's pulling
+	Scene::Transform p1_light_on;
+	Scene::Transform p2_light_off;
+	Scene::Transform p2_light_on;
+	Scene::Transform p1_flag;
+	Scene::Transform p2_flag;
+
+	Scene::Transform empty_box;
+	Scene::Transform trigger_box; // default
+	Scene::Transform adv_box_p1; // left player
+	Scene::Transform adv_box_p2; // right player
+	Scene::Transform counter_box; // default
+	Scene::Transform penalty_x1; // default
+	Scene::Transform penalty_x2; // default
 
 	const float HAND_OFFSET_X = 1.5f; // from rope center
 	const float LIGHT_OFFSET_X = 2.25f; // from rope center
@@ -0,0 +1,68 @@
+#include "Residency.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <cassert>
+
+size_t Residency::budget = 256 * 1024 * 1024;
+
+namespace {
+	std::vector< ResidentBase * > &get_residents() {
+		//(never destroyed, so Resident<>s at global scope can remove themselves at exit in any order)
+		static std::vector< ResidentBase * > *residents = new std::vector< ResidentBase * >();
+		return *residents;
+	}
+	size_t used_bytes = 0;
+	uint64_t use_stamp = 0;
+}
+
+void ResidentBase::set_bytes(size_t new_bytes) {
+	assert(used_bytes >= bytes);
+	used_bytes = used_bytes - bytes + new_bytes;
+	bytes = new_bytes;
+}
+
+size_t Residency::used() {
+	return used_bytes;
+}
+
+uint64_t Residency::next_use() {
+	return ++use_stamp;
+}
+
+void Residency::add(ResidentBase *resident) {
+	get_residents().emplace_back(resident);
+}
+
+void Residency::remove(ResidentBase *resident) {
+	auto &residents = get_residents();
+	auto f = std::find(residents.begin(), residents.end(), resident);
+	assert(f != residents.end());
+	residents.erase(f);
+	used_bytes -= resident->bytes;
+}
+
+void Residency::update() {
+	for (ResidentBase *resident : get_residents()) {
+		resident->finish_load();
+	}
+	if (used_bytes > budget) evict(budget);
+}
+
+void Residency::evict(size_t bytes) {
+	if (used_bytes <= bytes) return;
+
+	//candidates, least-recently-used first:
+	std::vector< ResidentBase * > candidates;
+	for (ResidentBase *resident : get_residents()) {
+		if (resident->resident() && !resident->in_use()) candidates.emplace_back(resident);
+	}
+	std::sort(candidates.begin(), candidates.end(), [](ResidentBase const *a, ResidentBase const *b) {
+		return a->last_used < b->last_used;
+	});
+
+	for (ResidentBase *resident : candidates) {
+		if (used_bytes <= bytes) break;
+		resident->evict();
+	}
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+/*
+ * A Resident< T > is a T that is loaded when it is first used and may be
+ *  evicted (and loaded again if it is used again) to keep the total size of
+ *  everything loaded this way under a memory budget.
+ *
+ * Use it (instead of Load< T >, which keeps things for the whole run) for
+ *  content that doesn't all need to be in memory at once:
+ *
+ * //at global scope:
+ * Resident< Sound::Sample > dusty_floor([]() {
+ *     return new Sound::Sample(data_path("dusty-floor.opus"));
+ * }, [](Sound::Sample const &sample) {
+ *     return sample.data.size() * sizeof(float);
+ * });
+ *
+ * //later:
+ * Sound::loop(dusty_floor.get());
+ *
+ * get() returns the value, loading it first if needed (blocking).
+ * try_get() never blocks: it starts loading on a worker thread and returns
+ *  'placeholder' (which may be null) until the value is ready.
+ *  If that load fails, the error is logged and try_get() keeps returning
+ *  'placeholder'; the next get() throws it (and a later get() tries again).
+ *
+ * The returned shared_ptr keeps the value alive; values still referenced
+ *  outside of their Resident<> (e.g., a sample that is playing) are never
+ *  evicted.
+ *
+ * Values that need GL calls to load (or free) use the split form: 'read'
+ *  (no GL calls; may run on a worker thread), then 'upload' (GL thread),
+ *  with 'unload' undoing 'upload' on eviction. get(), try_get() and
+ *  Residency::update() should all be called from the GL thread.
+ *
+ * Call Residency::update() once a frame: it finishes background loads and
+ *  evicts least-recently-used values while over Residency::budget.
+ */
+
+#include <functional>
+#include <future>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <exception>
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+
+struct ResidentBase;
+
+namespace Residency {
+	extern size_t budget; //bytes (default: 256MB)
+
+	//total size of resident values:
+	size_t used();
+
+	//finish background loads whose reads are done, then evict() down to the budget:
+	void update();
+
+	//evict least-recently-used values (that aren't in use) until at most 'bytes' are resident:
+	void evict(size_t bytes);
+
+	//internals:
+	void add(ResidentBase *);
+	void remove(ResidentBase *);
+	uint64_t next_use(); //(LRU stamps)
+}
+
+struct ResidentBase {
+	ResidentBase() { Residency::add(this); }
+	virtual ~ResidentBase() { Residency::remove(this); }
+	ResidentBase(ResidentBase const &) = delete;
+	ResidentBase &operator=(ResidentBase const &) = delete;
+
+	size_t bytes = 0; //size of the value (when resident)
+	uint64_t last_used = 0; //stamp from Residency::next_use()
+	void set_bytes(size_t new_bytes); //(keeps Residency::used() up to date)
+
+	virtual bool resident() const = 0;
+	virtual bool in_use() const = 0; //is the value referenced outside its Resident<>?
+	virtual void evict() = 0;
+	virtual void finish_load() = 0; //finish a background load, if its read is done
+};
+
+template< typename T >
+struct Resident : ResidentBase {
+	using Read = std::function< T *() >;
+	using Upload = std::function< void(T &) >;
+	using Size = std::function< size_t(T const &) >;
+
+	//load all at once ('load' may run on a worker thread, so no GL calls):
+	Resident(Read const &load, Size const &size_ = [](T const &) { return sizeof(T); })
+		: read(load), size(size_) { }
+
+	//..or in two parts, with 'unload' called (on the GL thread) before an evicted value is deleted:
+	Resident(Read const &read_, Upload const &upload_, Upload const &unload_, Size const &size_)
+		: read(read_), upload(upload_), unload(unload_), size(size_) { }
+
+	~Resident() {
+		if (reading.valid()) reading.wait();
+	}
+
+	//the value, loading it now if needed:
+	std::shared_ptr< T const > get() {
+		if (failed) {
+			std::exception_ptr error = failed;
+			failed = nullptr;
+			std::rethrow_exception(error);
+		}
+		if (!value) {
+			if (reading.valid()) finish(reading.get()); //(wait for the background load)
+			else finish(read());
+		}
+		last_used = Residency::next_use();
+		return keep_and_trim();
+	}
+
+	//the value if it is resident, otherwise 'placeholder' (while a load runs in the background):
+	std::shared_ptr< T const > try_get() {
+		if (failed) return placeholder; //(until get() reports the error)
+		if (!value) {
+			if (!reading.valid()) {
+				reading = std::async(std::launch::async, read);
+			} else {
+				finish_load();
+			}
+			if (!value) return placeholder;
+		}
+		last_used = Residency::next_use();
+		return keep_and_trim();
+	}
+
+	//returned by try_get() while loading:
+	std::shared_ptr< T const > placeholder;
+
+	//-- internals --
+	Read read;
+	Upload upload;
+	Upload unload;
+	Size size;
+
+	std::shared_ptr< T > value;
+	std::future< T * > reading;
+	std::exception_ptr failed; //error from a background load, for the next get()
+
+	bool resident() const override { return value != nullptr; }
+	bool in_use() const override { return value.use_count() > 1; }
+
+	void evict() override {
+		if (!value) return;
+		if (unload) unload(*value);
+		value.reset();
+		set_bytes(0);
+	}
+
+	void finish_load() override {
+		if (value || !reading.valid()) return;
+		if (reading.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+		//(called every frame from Residency::update(), so a failed load mustn't throw from here)
+		try {
+			finish(reading.get());
+		} catch (std::exception const &e) {
+			std::cerr << "Background load failed: " << e.what() << std::endl;
+			failed = std::current_exception();
+			return;
+		}
+		last_used = Residency::next_use();
+	}
+
+	void finish(T *loaded) {
+		if (!loaded) throw std::runtime_error("Loading failed.");
+		std::shared_ptr< T > ret(loaded);
+		if (upload) upload(*ret);
+		value = ret; //(only once uploaded, so a failed upload leaves nothing half-loaded)
+		set_bytes(size(*value));
+	}
+
+	//(hold a reference while evicting, so the value being returned isn't evicted itself)
+	std::shared_ptr< T const > keep_and_trim() {
+		std::shared_ptr< T const > ret = value;
+		if (Residency::used() > Residency::budget) Residency::evict(Residency::budget);
+		return ret;
+	}
+};
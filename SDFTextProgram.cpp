@@ -0,0 +1,62 @@
+#include "SDFTextProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+Load< SDFTextProgram > sdf_text_program(LoadTagEarly, LoadSubmitFirst(), SDFTextProgram::submit, [](GLProgramBuild &&build) -> SDFTextProgram const * {
+	return new SDFTextProgram(std::move(build));
+});
+
+GLProgramBuild SDFTextProgram::submit() {
+	return gl_submit_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec4 Position;\n"
+		"in vec4 Color;\n"
+		"in vec2 TexCoord;\n"
+		"out vec4 color;\n"
+		"out vec2 texCoord;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
+		"	color = Color;\n"
+		"	texCoord = TexCoord;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"uniform sampler2D TEX;\n"
+		"in vec4 color;\n"
+		"in vec2 texCoord;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	float dist = texture(TEX, texCoord).r;\n" //0.5 on the outline, larger inside
+		"	float width = max(fwidth(dist), 1e-4);\n" //how much 'dist' changes across one screen pixel
+		"	float coverage = smoothstep(0.5 - width, 0.5 + width, dist);\n"
+		"	fragColor = vec4(color.rgb, coverage * color.a);\n"
+		"}\n"
+	);
+}
+
+SDFTextProgram::SDFTextProgram(GLProgramBuild &&build) {
+	program = gl_await_program(std::move(build));
+
+	//look up the locations of vertex attributes:
+	Position_vec4 = glGetAttribLocation(program, "Position");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+	TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
+
+	//set TEX to always refer to texture binding zero:
+	glUseProgram(program);
+	glUniform1i(TEX_sampler2D, 0);
+	glUseProgram(0);
+}
+
+SDFTextProgram::~SDFTextProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "GL.hpp"
+#include "gl_compile_program.hpp"
+#include "Load.hpp"
+
+//Shader program that draws text from signed distance field glyphs (see GlyphAtlas::SDF), tinted with vertex colors:
+// the outline is where the distance texture crosses 0.5, and the edge is smoothed over about one
+// screen pixel, so glyphs stay sharp however much they are scaled (or rotated) by OBJECT_TO_CLIP.
+struct SDFTextProgram {
+	//start compiling the shaders (see gl_submit_program); the constructor waits for them to finish:
+	static GLProgramBuild submit();
+	SDFTextProgram(GLProgramBuild &&build = submit());
+	~SDFTextProgram();
+
+	GLuint program = 0;
+	//Attribute (per-vertex variable) locations:
+	GLuint Position_vec4 = -1U;
+	GLuint Color_vec4 = -1U;
+	GLuint TexCoord_vec2 = -1U;
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	//Textures:
+	//TEXTURE0 - distance field (single channel) that is accessed by TexCoord
+};
+
+extern Load< SDFTextProgram > sdf_text_program;
@@ -1,15 +1,36 @@
 #include "Scene.hpp"
 
 #include "gl_errors.hpp"
-#include "read_write_chunk.hpp"
+#include "MappedFile.hpp"
+#include "transform_batch.hpp"
+#include "Frustum.hpp"
+#include "StreamRing.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
-#include <fstream>
+#include <istream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 //-------------------------
 
-glm::mat4x3 Scene::Transform::make_parent_from_local() const {
+uint32_t Scene::Transforms::add(std::string const &name, uint32_t parent) {
+	assert(parent == NoTransform || parent < size()); //parents must come before children
+	uint32_t index = size();
+	names.emplace_back(name);
+	positions.emplace_back(0.0f, 0.0f, 0.0f);
+	rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+	scales.emplace_back(1.0f, 1.0f, 1.0f);
+	parents.emplace_back(parent);
+	return index;
+}
+
+glm::mat4x3 Scene::Transforms::make_parent_from_local(uint32_t index) const {
+	glm::vec3 const &position = positions[index];
+	glm::quat const &rotation = rotations[index];
+	glm::vec3 const &scale = scales[index];
+
 	//compute:
 	//   translate   *   rotate    *   scale
 	// [ 1 0 0 p.x ]   [       0 ]   [ s.x 0 0 0 ]
@@ -26,7 +47,11 @@ glm::mat4x3 Scene::Transform::make_parent_from_local() const {
 	);
 }
 
-glm::mat4x3 Scene::Transform::make_local_from_parent() const {
+glm::mat4x3 Scene::Transforms::make_local_from_parent(uint32_t index) const {
+	glm::vec3 const &position = positions[index];
+	glm::quat const &rotation = rotations[index];
+	glm::vec3 const &scale = scales[index];
+
 	//compute:
 	//   1/scale       *    rot^-1   *  translate^-1
 	// [ 1/s.x 0 0 0 ]   [       0 ]   [ 0 0 0 -p.x ]
@@ -56,21 +81,62 @@ glm::mat4x3 Scene::Transform::make_local_from_parent() const {
 	);
 }
 
-glm::mat4x3 Scene::Transform::make_world_from_local() const {
-	if (!parent) {
-		return make_parent_from_local();
+glm::mat4x3 Scene::Transforms::make_world_from_local(uint32_t index) const {
+	if (parents[index] == NoTransform) {
+		return make_parent_from_local(index);
 	} else {
-		return parent->make_world_from_local() * glm::mat4(make_parent_from_local()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+		return make_world_from_local(parents[index]) * glm::mat4(make_parent_from_local(index)); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
 	}
 }
-glm::mat4x3 Scene::Transform::make_local_from_world() const {
-	if (!parent) {
-		return make_local_from_parent();
+
+glm::mat4x3 Scene::Transforms::make_local_from_world(uint32_t index) const {
+	if (parents[index] == NoTransform) {
+		return make_local_from_parent(index);
 	} else {
-		return make_local_from_parent() * glm::mat4(parent->make_local_from_world()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+		return make_local_from_parent(index) * glm::mat4(make_local_from_world(parents[index])); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
 	}
 }
 
+void Scene::Transforms::update_world_from_local() const {
+	//new transforms get default (NaN) cache entries, so they are always computed:
+	world_from_local.resize(size(), glm::mat4x3(1.0f));
+	cached.resize(size());
+	cached_parent_from_local.resize(size(), glm::mat4x3(1.0f));
+	cached_changed.resize(size(), 0);
+
+	//find transforms whose parent_from_local is out of date, then recompute them all at once:
+	cached_todo.clear();
+	for (uint32_t i = 0; i < size(); ++i) {
+		Cached &c = cached[i];
+		bool local_changed = (positions[i] != c.position || rotations[i] != c.rotation || scales[i] != c.scale);
+		if (local_changed) {
+			c.position = positions[i];
+			c.rotation = rotations[i];
+			c.scale = scales[i];
+			cached_todo.emplace_back(i);
+		}
+		cached_changed[i] = local_changed;
+	}
+	make_parent_from_local_batch(uint32_t(cached_todo.size()), cached_todo.data(), positions.data(), rotations.data(), scales.data(), cached_parent_from_local.data());
+
+	//find transforms whose world_from_local is out of date:
+	// (since parents come before children, a parent's flag already says whether its world_from_local changed)
+	cached_todo.clear();
+	for (uint32_t i = 0; i < size(); ++i) {
+		Cached &c = cached[i];
+		uint32_t parent = parents[i];
+		assert(parent == NoTransform || parent < i);
+
+		bool changed = cached_changed[i] || parent != c.parent || (parent != NoTransform && cached_changed[parent]);
+		if (changed) {
+			c.parent = parent;
+			cached_todo.emplace_back(i);
+		}
+		cached_changed[i] = changed;
+	}
+	make_world_from_local_batch(uint32_t(cached_todo.size()), cached_todo.data(), parents.data(), cached_parent_from_local.data(), world_from_local.data());
+}
+
 //-------------------------
 
 glm::mat4 Scene::Camera::make_projection() const {
@@ -80,18 +146,210 @@ glm::mat4 Scene::Camera::make_projection() const {
 //-------------------------
 
 
+//world-space bounds of a drawable (as a BVH box), or false if it has no bounds:
+static bool drawable_box(Scene const &scene, Scene::Drawable const &drawable, BVH::Box *box) {
+	if (!(drawable.min.x <= drawable.max.x && drawable.min.y <= drawable.max.y && drawable.min.z <= drawable.max.z)) return false;
+	glm::vec3 center, radius;
+	Frustum::world_box(scene.transforms.world_from_local[drawable.transform], drawable.min, drawable.max, &center, &radius);
+	box->min = center - radius;
+	box->max = center + radius;
+	return true;
+}
+
+void Scene::update_world_from_local() const {
+	transforms.update_world_from_local();
+
+	DrawableBVH &dbvh = drawable_bvh;
+	if (dbvh.stale || dbvh.drawable_count != drawables.size() || dbvh.transform_count != transforms.size()) {
+		//structure changed; rebuild from scratch:
+		dbvh.drawables.clear();
+		dbvh.unbounded.clear();
+		std::vector< BVH::Box > boxes;
+		boxes.reserve(drawables.size());
+		for (uint32_t i = 0; i < drawables.size(); ++i) {
+			BVH::Box box;
+			if (drawable_box(*this, drawables[i], &box)) {
+				dbvh.drawables.emplace_back(i);
+				boxes.emplace_back(box);
+			} else {
+				dbvh.unbounded.emplace_back(i);
+			}
+		}
+		dbvh.bvh.build(boxes);
+
+		//index items by transform, for refitting:
+		dbvh.by_transform_begin.assign(transforms.size() + 1, 0);
+		for (uint32_t d : dbvh.drawables) {
+			dbvh.by_transform_begin[drawables[d].transform + 1] += 1;
+		}
+		for (uint32_t t = 0; t < transforms.size(); ++t) {
+			dbvh.by_transform_begin[t + 1] += dbvh.by_transform_begin[t];
+		}
+		dbvh.by_transform.resize(dbvh.drawables.size());
+		std::vector< uint32_t > next(dbvh.by_transform_begin.begin(), dbvh.by_transform_begin.end() - 1);
+		for (uint32_t item = 0; item < dbvh.drawables.size(); ++item) {
+			dbvh.by_transform[next[drawables[dbvh.drawables[item]].transform]++] = item;
+		}
+
+		dbvh.drawable_count = drawables.size();
+		dbvh.transform_count = transforms.size();
+		dbvh.stale = false;
+	} else {
+		//refit around drawables on transforms that moved:
+		for (uint32_t t : transforms.cached_todo) {
+			for (uint32_t k = dbvh.by_transform_begin[t]; k < dbvh.by_transform_begin[t + 1]; ++k) {
+				uint32_t item = dbvh.by_transform[k];
+				BVH::Box box;
+				[[maybe_unused]] bool bounded = drawable_box(*this, drawables[dbvh.drawables[item]], &box);
+				assert(bounded);
+				dbvh.bvh.update(item, box);
+			}
+		}
+		dbvh.bvh.refit();
+	}
+}
+
+uint32_t Scene::pick(glm::vec3 const &origin, glm::vec3 const &direction, float *t) const {
+	uint32_t item = drawable_bvh.bvh.pick(origin, direction, std::numeric_limits< float >::infinity(), t);
+	return (item == -1U ? -1U : drawable_bvh.drawables[item]);
+}
+
+char const *Scene::FrameBlockGLSL =
+	"layout(std140) uniform Frame {\n"
+	"	mat4 CLIP_FROM_WORLD;\n"
+	"	vec3 LIGHT_LOCATION;\n"
+	"	int LIGHT_TYPE;\n"
+	"	vec3 LIGHT_DIRECTION;\n"
+	"	float LIGHT_CUTOFF;\n"
+	"	vec3 LIGHT_ENERGY;\n"
+	"};\n";
+
+char const *Scene::ObjectBlockGLSL =
+	"layout(std140) uniform Object {\n"
+	"	mat4 CLIP_FROM_OBJECT;\n"
+	"	mat4x3 LIGHT_FROM_OBJECT;\n"
+	"	mat3 LIGHT_FROM_NORMAL;\n"
+	"};\n";
+
+//Ring buffer that draw() writes uniform blocks into:
+// (shared by all scenes, since scenes are copied around freely and GL objects can't be)
+static StreamRing &uniform_ring() {
+	static StreamRing ring(GL_UNIFORM_BUFFER, 16);
+	return ring;
+}
+
+//Buffer that draw() uploads multi-draw-indirect commands to:
+// (also shared by all scenes)
+static GLuint indirect_buffer() {
+	static GLuint buffer = 0;
+	if (buffer == 0) glGenBuffers(1, &buffer);
+	return buffer;
+}
+
 void Scene::draw(Camera const &camera) const {
-	assert(camera.transform);
-	glm::mat4 clip_from_world = camera.make_projection() * glm::mat4(camera.transform->make_local_from_world());
+	assert(camera.transform < transforms.size());
+	glm::mat4 clip_from_world = camera.make_projection() * glm::mat4(transforms.make_local_from_world(camera.transform));
 	glm::mat4x3 light_from_world = glm::mat4x3(1.0f);
 	draw(clip_from_world, light_from_world);
 }
 
+//sort key for a drawable: [program:16][vao:16][textures:16][depth:16], so drawables sharing state end up together
+// (names are truncated, so unrelated state can share a key -- this only affects the order, not what gets bound)
+static uint64_t make_draw_key(Scene::Drawable::Pipeline const &pipeline, float depth) {
+	uint32_t textures = 0;
+	for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount; ++i) {
+		textures = textures * 31 + pipeline.textures[i].texture;
+	}
+	//(for non-negative floats, the bit pattern increases with the value)
+	float d = std::max(depth, 0.0f);
+	uint32_t depth_bits;
+	std::memcpy(&depth_bits, &d, sizeof(depth_bits));
+
+	return (uint64_t(pipeline.program & 0xffff) << 48)
+	     | (uint64_t(pipeline.vao & 0xffff) << 32)
+	     | (uint64_t(textures & 0xffff) << 16)
+	     | uint64_t(depth_bits >> 16);
+}
+
+//can this pipeline be drawn with its instanced version?
+static bool instanceable(Scene::Drawable::Pipeline const &pipeline) {
+	return pipeline.instanced.program != 0 && pipeline.instanced.vao != 0 && pipeline.instanced.buffer != 0
+	    && !pipeline.set_uniforms; //(can't tell whether two set_uniforms functions do the same thing)
+}
+
+//would drawing with these two pipelines do the same thing, apart from per-object matrices (and, if 'any_mesh', which vertices are drawn)?
+static bool same_instanced_pipeline(Scene::Drawable::Pipeline const &a, Scene::Drawable::Pipeline const &b, bool any_mesh) {
+	if (!instanceable(b)) return false;
+	if (a.program != b.program || a.vao != b.vao) return false;
+	if (a.type != b.type || a.index_type != b.index_type) return false;
+	if (!any_mesh && (a.start != b.start || a.count != b.count)) return false;
+	if (a.instanced.program != b.instanced.program || a.instanced.vao != b.instanced.vao || a.instanced.buffer != b.instanced.buffer) return false;
+	for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount; ++i) {
+		if (a.textures[i].texture != b.textures[i].texture) return false;
+		if (a.textures[i].texture != 0 && a.textures[i].target != b.textures[i].target) return false;
+	}
+	return true;
+}
+
+//bytes per index for glDrawElements* index types:
+static uint32_t index_size(GLenum index_type) {
+	if (index_type == GL_UNSIGNED_INT) return 4;
+	if (index_type == GL_UNSIGNED_SHORT) return 2;
+	assert(index_type == GL_UNSIGNED_BYTE);
+	return 1;
+}
+
+//stable LSD radix sort of 'items' by key, one byte at a time ('scratch' is working space):
+static void radix_sort(std::vector< Scene::DrawItem > *items_, std::vector< Scene::DrawItem > *scratch_) {
+	auto &items = *items_;
+	auto &scratch = *scratch_;
+	if (items.size() < 2) return;
+	scratch.resize(items.size());
+
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		uint32_t offsets[256] = { };
+		for (auto const &item : items) {
+			offsets[(item.key >> shift) & 0xff] += 1;
+		}
+		//skip bytes that are the same for every item (most of them, in practice):
+		if (offsets[(items[0].key >> shift) & 0xff] == items.size()) continue;
+
+		uint32_t total = 0;
+		for (uint32_t &offset : offsets) {
+			uint32_t count = offset;
+			offset = total;
+			total += count;
+		}
+		for (auto const &item : items) {
+			scratch[offsets[(item.key >> shift) & 0xff]++] = item;
+		}
+		std::swap(items, scratch);
+	}
+}
+
 void Scene::draw(glm::mat4 const &clip_from_world, glm::mat4x3 const &light_from_world) const {
+	//refresh every transform's world_from_local once, rather than walking up the hierarchy per drawable:
+	update_world_from_local();
 
-	//Iterate through all drawables, sending each one to OpenGL:
-	for (auto const &drawable : drawables) {
-		//Reference to drawable's pipeline for convenience:
+	draw_stats = DrawStats();
+	uint32_t unsorted_changes = 0; //(what binding everything for every drawable -- and un-binding textures after -- would take)
+
+	Frustum frustum(clip_from_world);
+
+	//Find drawables with bounds in view (plus all drawables without bounds):
+	draw_visible.clear();
+	drawable_bvh.bvh.query(frustum, &draw_visible);
+	draw_stats.culled = drawable_bvh.bvh.size() - uint32_t(draw_visible.size());
+	for (uint32_t &v : draw_visible) {
+		v = drawable_bvh.drawables[v];
+	}
+	draw_visible.insert(draw_visible.end(), drawable_bvh.unbounded.begin(), drawable_bvh.unbounded.end());
+	if (!sort_drawables) std::sort(draw_visible.begin(), draw_visible.end());
+
+	//Build a queue of the drawables that will actually draw something:
+	draw_queue.clear();
+	for (uint32_t i : draw_visible) {
+		Drawable const &drawable = drawables[i];
 		Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
 
 		//skip any drawables without a shader program set:
@@ -101,63 +359,259 @@ void Scene::draw(glm::mat4 const &clip_from_world, glm::mat4x3 const &light_from
 		//skip any drawables that don't contain any vertices:
 		if (pipeline.count == 0) continue;
 
+		uint64_t key = 0;
+		if (sort_drawables) {
+			//(front-to-back within the same state, so the depth test can reject more fragments early)
+			glm::vec3 const &origin = transforms.world_from_local[drawable.transform][3];
+			float depth = (clip_from_world * glm::vec4(origin, 1.0f)).w;
+			key = make_draw_key(pipeline, depth);
+			if (instanceable(pipeline)) {
+				//(instanced drawables are grouped by mesh instead, so copies of the same mesh end up next to each other)
+				key = (key & ~uint64_t(0xffff)) | uint64_t((pipeline.start * 31 + pipeline.count) & 0xffff);
+			}
+		}
+		draw_queue.emplace_back(DrawItem{ key, i });
+	}
 
-		//Set shader program:
-		glUseProgram(pipeline.program);
+	if (sort_drawables) radix_sort(&draw_queue, &draw_queue_scratch);
+
+	//Group the queue into draw calls:
+	// drawables that follow one another in the queue and only differ in their transform can be drawn together (instanced);
+	// with multi-draw-indirect, so can ones that only differ in their transform and mesh
+	bool indirect = (multi_draw_indirect && gl_indirect.MultiDrawArraysIndirect != nullptr);
+	draw_batches.clear();
+	uint32_t objects = 0;
+	for (uint32_t q = 0; q < draw_queue.size(); ) {
+		Scene::Drawable::Pipeline const &pipeline = drawables[draw_queue[q].drawable].pipeline;
+		uint32_t run = 1;
+		if (instanceable(pipeline)) {
+			while (q + run < draw_queue.size() && same_instanced_pipeline(pipeline, drawables[draw_queue[q + run].drawable].pipeline, indirect)) {
+				run += 1;
+			}
+		}
+		uint32_t object = -1U;
+		if (run == 1 && pipeline.object_block) object = objects++;
+		draw_batches.emplace_back(DrawBatch{ q, run, object });
+		q += run;
+	}
 
-		//Set attribute sources:
-		glBindVertexArray(pipeline.vao);
+	//Write this frame's uniform blocks -- 'Frame', then an 'Object' per (non-instanced) drawable that wants one:
+	StreamRing &ring = uniform_ring();
+	ring.create(); //(so 'alignment' is known before computing strides)
+	GLsizeiptr frame_stride = ring.align(sizeof(FrameUniforms));
+	GLsizeiptr object_stride = ring.align(sizeof(ObjectUniforms));
+	GLsizeiptr uniforms_offset = 0;
+	{
+		char *uniforms = ring.map(frame_stride + objects * object_stride, &uniforms_offset);
+
+		FrameUniforms frame = frame_uniforms;
+		frame.clip_from_world = clip_from_world;
+		std::memcpy(uniforms, &frame, sizeof(frame));
+
+		//(computed in one pass here, rather than as each drawable is drawn)
+		for (DrawBatch const &batch : draw_batches) {
+			if (batch.object == -1U) continue;
+			Drawable const &drawable = drawables[draw_queue[batch.begin].drawable];
+			assert(drawable.transform < transforms.size()); //drawables *must* have a transform
+			glm::mat4x3 const &world_from_object = transforms.world_from_local[drawable.transform];
+
+			glm::mat4x3 light_from_object = light_from_world * glm::mat4(world_from_object);
+			glm::mat3 light_from_normal = glm::inverse(glm::transpose(glm::mat3(light_from_object)));
 
-		//Configure program uniforms:
+			ObjectUniforms object;
+			object.clip_from_object = clip_from_world * glm::mat4(world_from_object);
+			for (uint32_t c = 0; c < 4; ++c) object.light_from_object[c] = glm::vec4(light_from_object[c], 0.0f);
+			for (uint32_t c = 0; c < 3; ++c) object.light_from_normal[c] = glm::vec4(light_from_normal[c], 0.0f);
+			std::memcpy(uniforms + frame_stride + batch.object * object_stride, &object, sizeof(object));
+		}
 
-		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable.transform); //drawables *must* have a transform
-		glm::mat4x3 world_from_object = drawable.transform->make_world_from_local();
+		ring.unmap();
+	}
+	glBindBufferRange(GL_UNIFORM_BUFFER, FrameBinding, ring.buffer, uniforms_offset, sizeof(FrameUniforms));
+
+	//Only change OpenGL state when it differs from what the previous drawable used:
+	GLuint bound_program = 0;
+	GLuint bound_vao = 0;
+	Drawable::Pipeline::TextureInfo bound_textures[Drawable::Pipeline::TextureCount];
+	uint32_t active_texture = 0;
+
+	auto bind_program_and_vao = [&](GLuint program, GLuint vao) {
+		if (program != bound_program) {
+			glUseProgram(program);
+			bound_program = program;
+			draw_stats.state_changes += 1;
+		}
+		if (vao != bound_vao) {
+			glBindVertexArray(vao);
+			bound_vao = vao;
+			draw_stats.state_changes += 1;
+		}
+	};
 
-		//CLIP_FROM_OBJECT takes vertices from object space to clip space:
-		if (pipeline.CLIP_FROM_OBJECT_mat4 != -1U) {
-			glm::mat4 clip_from_object = clip_from_world * glm::mat4(world_from_object);
-			glUniformMatrix4fv(pipeline.CLIP_FROM_OBJECT_mat4, 1, GL_FALSE, glm::value_ptr(clip_from_object));
+	//set_uniforms functions may change any state, so forget what is bound after calling one:
+	// (-1U is never a valid name, so everything gets bound again)
+	auto call_set_uniforms = [&](Drawable::Pipeline const &pipeline, GLuint program, GLuint vao) {
+		pipeline.set_uniforms();
+		bound_program = -1U;
+		bound_vao = -1U;
+		for (auto &bound : bound_textures) {
+			bound.texture = -1U;
 		}
+		active_texture = -1U;
+		bind_program_and_vao(program, vao);
+	};
 
-		//the object-to-light matrix is used in the next two uniforms:
-		glm::mat4x3 light_from_object = light_from_world * glm::mat4(world_from_object);
+	auto bind_texture = [&](uint32_t unit, Drawable::Pipeline::TextureInfo const &info) {
+		Drawable::Pipeline::TextureInfo &bound = bound_textures[unit];
+		if (bound.texture == info.texture && (info.texture == 0 || bound.target == info.target)) return;
 
-		//CLIP_FROM_OBJECT takes vertices from object space to light space:
-		if (pipeline.LIGHT_FROM_OBJECT_mat4x3 != -1U) {
-			glUniformMatrix4x3fv(pipeline.LIGHT_FROM_OBJECT_mat4x3, 1, GL_FALSE, glm::value_ptr(light_from_object));
+		if (active_texture != unit) {
+			glActiveTexture(GL_TEXTURE0 + unit);
+			active_texture = unit;
 		}
-
-		//LIGHT_FROM_NORMAL takes normals from object space to light space:
-		if (pipeline.LIGHT_FROM_NORMAL_mat3 != -1U) {
-			glm::mat3 light_from_normal = glm::inverse(glm::transpose(glm::mat3(light_from_object)));
-			glUniformMatrix3fv(pipeline.LIGHT_FROM_NORMAL_mat3, 1, GL_FALSE, glm::value_ptr(light_from_normal));
+		if (bound.texture != 0 && (info.texture == 0 || bound.target != info.target)) {
+			glBindTexture(bound.target, 0);
+			draw_stats.state_changes += 1;
 		}
+		if (info.texture != 0) {
+			glBindTexture(info.target, info.texture);
+			draw_stats.state_changes += 1;
+		}
+		bound = info;
+	};
 
-		//set any requested custom uniforms:
-		if (pipeline.set_uniforms) pipeline.set_uniforms();
+	//Iterate through the batches, sending each drawable (or run of instanced drawables) to OpenGL:
+	for (DrawBatch const &batch : draw_batches) {
+		Drawable const &drawable = drawables[draw_queue[batch.begin].drawable];
 
-		//set up textures:
+		//Reference to drawable's pipeline for convenience:
+		Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
+
+		uint32_t run = batch.count;
+		bool instanced = (run > 1);
+
+		draw_stats.draws += run;
+		draw_stats.draw_calls += 1;
+		if (instanced) draw_stats.instanced += run;
 		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, pipeline.textures[i].texture);
-			}
+			if (pipeline.textures[i].texture != 0) unsorted_changes += 2 * run;
 		}
+		unsorted_changes += 2 * run;
+
+		//Set shader program and attribute sources:
+		GLuint program = (instanced ? pipeline.instanced.program : pipeline.program);
+		GLuint vao = (instanced ? pipeline.instanced.vao : pipeline.vao);
+		bind_program_and_vao(program, vao);
+
+		if (instanced) {
+			//Per-instance matrices go to the instance buffer instead of uniforms:
+			// (and each stretch of the same mesh becomes one indirect command, with base_instance pointing at its matrices)
+			draw_instances.resize(run);
+			draw_commands.clear();
+			for (uint32_t r = 0; r < run; ++r) {
+				Drawable const &instance = drawables[draw_queue[batch.begin + r].drawable];
+				assert(instance.transform < transforms.size()); //drawables *must* have a transform
+				glm::mat4x3 const &world_from_object = transforms.world_from_local[instance.transform];
+
+				Instance &out = draw_instances[r];
+				out.clip_from_object = clip_from_world * glm::mat4(world_from_object);
+				out.light_from_object = light_from_world * glm::mat4(world_from_object);
+				out.light_from_normal = glm::inverse(glm::transpose(glm::mat3(out.light_from_object)));
+
+				if (draw_commands.empty() || draw_commands.back().first != instance.pipeline.start || draw_commands.back().count != instance.pipeline.count) {
+					draw_commands.emplace_back(DrawArraysIndirectCommand{ instance.pipeline.count, 0, instance.pipeline.start, r });
+				}
+				draw_commands.back().instance_count += 1;
+			}
+
+			//(re-specifying the whole buffer lets the driver hand back fresh storage instead of waiting on earlier draws that read it)
+			glBindBuffer(GL_ARRAY_BUFFER, pipeline.instanced.buffer);
+			glBufferData(GL_ARRAY_BUFFER, run * sizeof(Instance), draw_instances.data(), GL_STREAM_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		} else if (batch.object != -1U) {
+			//Matrices were written to the uniform ring above:
+			glBindBufferRange(GL_UNIFORM_BUFFER, ObjectBinding, ring.buffer, uniforms_offset + frame_stride + batch.object * object_stride, sizeof(ObjectUniforms));
+
+			//set any requested custom uniforms:
+			if (pipeline.set_uniforms) call_set_uniforms(pipeline, program, vao);
+		} else {
+			//Configure program uniforms:
 
-		//draw the object:
-		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
+			//the object-to-world matrix is used in all three of these uniforms:
+			assert(drawable.transform < transforms.size()); //drawables *must* have a transform
+			glm::mat4x3 const &world_from_object = transforms.world_from_local[drawable.transform];
 
-		//un-bind textures:
+			//CLIP_FROM_OBJECT takes vertices from object space to clip space:
+			if (pipeline.CLIP_FROM_OBJECT_mat4 != -1U) {
+				glm::mat4 clip_from_object = clip_from_world * glm::mat4(world_from_object);
+				glUniformMatrix4fv(pipeline.CLIP_FROM_OBJECT_mat4, 1, GL_FALSE, glm::value_ptr(clip_from_object));
+			}
+
+			//the object-to-light matrix is used in the next two uniforms:
+			glm::mat4x3 light_from_object = light_from_world * glm::mat4(world_from_object);
+
+			//CLIP_FROM_OBJECT takes vertices from object space to light space:
+			if (pipeline.LIGHT_FROM_OBJECT_mat4x3 != -1U) {
+				glUniformMatrix4x3fv(pipeline.LIGHT_FROM_OBJECT_mat4x3, 1, GL_FALSE, glm::value_ptr(light_from_object));
+			}
+
+			//LIGHT_FROM_NORMAL takes normals from object space to light space:
+			if (pipeline.LIGHT_FROM_NORMAL_mat3 != -1U) {
+				glm::mat3 light_from_normal = glm::inverse(glm::transpose(glm::mat3(light_from_object)));
+				glUniformMatrix3fv(pipeline.LIGHT_FROM_NORMAL_mat3, 1, GL_FALSE, glm::value_ptr(light_from_normal));
+			}
+
+			//set any requested custom uniforms:
+			if (pipeline.set_uniforms) call_set_uniforms(pipeline, program, vao);
+		}
+
+		//set up textures (units this drawable doesn't use are left empty, as before):
 		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, 0);
+			bind_texture(i, pipeline.textures[i]);
+		}
+
+		//draw the object(s):
+		bool indexed = (pipeline.index_type != GL_NONE);
+		if (instanced && draw_commands.size() > 1) {
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer());
+			if (indexed) {
+				draw_element_commands.clear();
+				for (DrawArraysIndirectCommand const &c : draw_commands) {
+					draw_element_commands.emplace_back(DrawElementsIndirectCommand{ c.count, c.instance_count, c.first, 0, c.base_instance });
+				}
+				glBufferData(GL_DRAW_INDIRECT_BUFFER, draw_element_commands.size() * sizeof(DrawElementsIndirectCommand), draw_element_commands.data(), GL_STREAM_DRAW);
+				gl_indirect.MultiDrawElementsIndirect(pipeline.type, pipeline.index_type, nullptr, GLsizei(draw_element_commands.size()), 0);
+			} else {
+				glBufferData(GL_DRAW_INDIRECT_BUFFER, draw_commands.size() * sizeof(DrawArraysIndirectCommand), draw_commands.data(), GL_STREAM_DRAW);
+				gl_indirect.MultiDrawArraysIndirect(pipeline.type, nullptr, GLsizei(draw_commands.size()), 0);
+			}
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			draw_stats.indirect_commands += uint32_t(draw_commands.size());
+		} else if (instanced) {
+			if (indexed) {
+				glDrawElementsInstanced(pipeline.type, pipeline.count, pipeline.index_type, (GLbyte *)0 + pipeline.start * index_size(pipeline.index_type), run);
+			} else {
+				glDrawArraysInstanced(pipeline.type, pipeline.start, pipeline.count, run);
+			}
+		} else {
+			if (indexed) {
+				glDrawElements(pipeline.type, pipeline.count, pipeline.index_type, (GLbyte *)0 + pipeline.start * index_size(pipeline.index_type));
+			} else {
+				glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
 			}
 		}
-		glActiveTexture(GL_TEXTURE0);
+	}
 
+	//(the uniform ring range can be reused once the GPU gets past these draws)
+	ring.fence();
+
+	//un-bind textures:
+	for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
+		bind_texture(i, Drawable::Pipeline::TextureInfo());
 	}
+	glActiveTexture(GL_TEXTURE0);
+
+	draw_stats.state_changes_avoided = unsorted_changes - std::min(draw_stats.state_changes, unsorted_changes);
 
 	glUseProgram(0);
 	glBindVertexArray(0);
@@ -167,12 +621,12 @@ void Scene::draw(glm::mat4 const &clip_from_world, glm::mat4x3 const &light_from
 
 
 void Scene::load(std::string const &filename,
-	std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
+	std::function< void(Scene &, uint32_t, std::string const &) > const &on_drawable) {
 
-	std::ifstream file(filename, std::ios::binary);
+	//(chunks are read in place from the mapped file rather than copied out)
+	MappedFile file(filename);
 
-	std::vector< char > names;
-	read_chunk(file, "str0", &names);
+	std::span< char const > names = file.read_chunk< char >("str0");
 
 	struct HierarchyEntry {
 		uint32_t parent;
@@ -183,8 +637,7 @@ void Scene::load(std::string const &filename,
 		glm::vec3 scale;
 	};
 	static_assert(sizeof(HierarchyEntry) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "HierarchyEntry is packed.");
-	std::vector< HierarchyEntry > hierarchy;
-	read_chunk(file, "xfh0", &hierarchy);
+	std::span< HierarchyEntry const > hierarchy = file.read_chunk< HierarchyEntry >("xfh0");
 
 	struct MeshEntry {
 		uint32_t transform;
@@ -192,8 +645,7 @@ void Scene::load(std::string const &filename,
 		uint32_t name_end;
 	};
 	static_assert(sizeof(MeshEntry) == 4 + 4 + 4, "MeshEntry is packed.");
-	std::vector< MeshEntry > meshes;
-	read_chunk(file, "msh0", &meshes);
+	std::span< MeshEntry const > meshes = file.read_chunk< MeshEntry >("msh0");
 
 	struct CameraEntry {
 		uint32_t transform;
@@ -202,8 +654,7 @@ void Scene::load(std::string const &filename,
 		float clip_near, clip_far;
 	};
 	static_assert(sizeof(CameraEntry) == 4 + 4 + 4 + 4 + 4, "CameraEntry is packed.");
-	std::vector< CameraEntry > loaded_cameras;
-	read_chunk(file, "cam0", &loaded_cameras);
+	std::span< CameraEntry const > loaded_cameras = file.read_chunk< CameraEntry >("cam0");
 
 	struct LightEntry {
 		uint32_t transform;
@@ -214,42 +665,45 @@ void Scene::load(std::string const &filename,
 		float fov;
 	};
 	static_assert(sizeof(LightEntry) == 4 + 1 + 3 + 4 + 4 + 4, "LightEntry is packed.");
-	std::vector< LightEntry > loaded_lights;
-	read_chunk(file, "lmp0", &loaded_lights);
+	std::span< LightEntry const > loaded_lights = file.read_chunk< LightEntry >("lmp0");
 
 
 	//--------------------------------
 	//Now that file is loaded, create transforms for hierarchy entries:
 
-	std::vector< Transform * > hierarchy_transforms;
-	hierarchy_transforms.reserve(hierarchy.size());
+	//(hierarchy entry i becomes transform xfh0_begin + i; entries are already in parents-first order)
+	uint32_t xfh0_begin = transforms.size();
+	uint32_t xfh0_count = uint32_t(hierarchy.size());
+
+	transforms.names.reserve(xfh0_begin + xfh0_count);
+	transforms.positions.reserve(xfh0_begin + xfh0_count);
+	transforms.rotations.reserve(xfh0_begin + xfh0_count);
+	transforms.scales.reserve(xfh0_begin + xfh0_count);
+	transforms.parents.reserve(xfh0_begin + xfh0_count);
 
 	for (auto const &h : hierarchy) {
-		transforms.emplace_back();
-		Transform *t = &transforms.back();
+		uint32_t parent = NoTransform;
 		if (h.parent != -1U) {
-			if (h.parent >= hierarchy_transforms.size()) {
+			if (h.parent >= transforms.size() - xfh0_begin) {
 				throw std::runtime_error("scene file '" + filename + "' did not contain transforms in topological-sort order.");
 			}
-			t->parent = hierarchy_transforms[h.parent];
+			parent = xfh0_begin + h.parent;
 		}
 
-		if (h.name_begin <= h.name_end && h.name_end <= names.size()) {
-			t->name = std::string(names.begin() + h.name_begin, names.begin() + h.name_end);
-		} else {
+		if (!(h.name_begin <= h.name_end && h.name_end <= names.size())) {
 				throw std::runtime_error("scene file '" + filename + "' contains hierarchy entry with invalid name indices");
 		}
 
-		t->position = h.position;
-		t->rotation = h.rotation;
-		t->scale = h.scale;
-
-		hierarchy_transforms.emplace_back(t);
+		transforms.names.emplace_back(names.begin() + h.name_begin, names.begin() + h.name_end);
+		transforms.positions.emplace_back(h.position);
+		transforms.rotations.emplace_back(h.rotation);
+		transforms.scales.emplace_back(h.scale);
+		transforms.parents.emplace_back(parent);
 	}
-	assert(hierarchy_transforms.size() == hierarchy.size());
+	assert(transforms.size() == xfh0_begin + xfh0_count);
 
 	for (auto const &m : meshes) {
-		if (m.transform >= hierarchy_transforms.size()) {
+		if (m.transform >= xfh0_count) {
 			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid transform index (" + std::to_string(m.transform) + ")");
 		}
 		if (!(m.name_begin <= m.name_end && m.name_end <= names.size())) {
@@ -258,20 +712,20 @@ void Scene::load(std::string const &filename,
 		std::string name = std::string(names.begin() + m.name_begin, names.begin() + m.name_end);
 
 		if (on_drawable) {
-			on_drawable(*this, hierarchy_transforms[m.transform], name);
+			on_drawable(*this, xfh0_begin + m.transform, name);
 		}
 
 	}
 
 	for (auto const &c : loaded_cameras) {
-		if (c.transform >= hierarchy_transforms.size()) {
+		if (c.transform >= xfh0_count) {
 			throw std::runtime_error("scene file '" + filename + "' contains camera entry with invalid transform index (" + std::to_string(c.transform) + ")");
 		}
 		if (std::string(c.type, 4) != "pers") {
 			std::cout << "Ignoring non-perspective camera (" + std::string(c.type, 4) + ") stored in file." << std::endl;
 			continue;
 		}
-		cameras.emplace_back(hierarchy_transforms[c.transform]);
+		cameras.emplace_back(xfh0_begin + c.transform);
 		Camera *camera = &cameras.back();
 		camera->fovy = c.data / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
 		camera->near = c.clip_near;
@@ -279,7 +733,7 @@ void Scene::load(std::string const &filename,
 	}
 
 	for (auto const &l : loaded_lights) {
-		if (l.transform >= hierarchy_transforms.size()) {
+		if (l.transform >= xfh0_count) {
 			throw std::runtime_error("scene file '" + filename + "' contains lamp entry with invalid transform index (" + std::to_string(l.transform) + ")");
 		}
 		if (l.type == 'p') {
@@ -294,17 +748,25 @@ void Scene::load(std::string const &filename,
 			std::cout << "Ignoring unrecognized lamp type (" + std::string(&l.type, 1) + ") stored in file." << std::endl;
 			continue;
 		}
-		lights.emplace_back(hierarchy_transforms[l.transform]);
+		lights.emplace_back(xfh0_begin + l.transform);
 		Light *light = &lights.back();
 		light->type = static_cast<Light::Type>(l.type);
 		light->energy = glm::vec3(l.color) / 255.0f * l.energy;
 		light->spot_fov = l.fov / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
 	}
 
-	//load any extra that a subclass wants:
-	load_extra(file, names, hierarchy_transforms);
+	//load any extra that a subclass wants (from a stream over the rest of the mapped file):
+	struct RestBuf : std::streambuf {
+		RestBuf(char const *begin, char const *end) {
+			setg(const_cast< char * >(begin), const_cast< char * >(begin), const_cast< char * >(end));
+		}
+		size_t consumed() const { return size_t(gptr() - eback()); }
+	} rest(file.data + file.offset, file.data + file.size);
+	std::istream rest_stream(&rest);
+	load_extra(rest_stream, std::vector< char >(names.begin(), names.end()), xfh0_begin);
+	file.offset += rest.consumed();
 
-	if (file.peek() != EOF) {
+	if (!file.at_end()) {
 		std::cerr << "WARNING: trailing data in scene file '" << filename << "'" << std::endl;
 	}
 
@@ -314,64 +776,6 @@ void Scene::load(std::string const &filename,
 
 //-------------------------
 
-Scene::Scene(std::string const &filename, std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
+Scene::Scene(std::string const &filename, std::function< void(Scene &, uint32_t, std::string const &) > const &on_drawable) {
 	load(filename, on_drawable);
 }
-
-Scene::Scene(Scene const &other) {
-	set(other);
-}
-
-Scene &Scene::operator=(Scene const &other) {
-	set(other);
-	return *this;
-}
-
-void Scene::set(Scene const &other, std::unordered_map< Transform const *, Transform * > *transform_map_) {
-
-	std::unordered_map< Transform const *, Transform * > t2t_temp;
-	std::unordered_map< Transform const *, Transform * > &transform_to_transform = *(transform_map_ ? transform_map_ : &t2t_temp);
-
-	transform_to_transform.clear();
-
-	//null transform maps to itself:
-	transform_to_transform.insert(std::make_pair(nullptr, nullptr));
-
-	//Copy transforms and store mapping:
-	transforms.clear();
-	for (auto const &t : other.transforms) {
-		transforms.emplace_back();
-		transforms.back().name = t.name;
-		transforms.back().position = t.position;
-		transforms.back().rotation = t.rotation;
-		transforms.back().scale = t.scale;
-		transforms.back().parent = t.parent; //will update later
-
-		//store mapping between transforms old and new:
-		auto ret = transform_to_transform.insert(std::make_pair(&t, &transforms.back()));
-		assert(ret.second);
-	}
-
-	//update transform parents:
-	for (auto &t : transforms) {
-		t.parent = transform_to_transform.at(t.parent);
-	}
-
-	//copy other's drawables, updating transform pointers:
-	drawables = other.drawables;
-	for (auto &d : drawables) {
-		d.transform = transform_to_transform.at(d.transform);
-	}
-
-	//copy other's cameras, updating transform pointers:
-	cameras = other.cameras;
-	for (auto &c : cameras) {
-		c.transform = transform_to_transform.at(c.transform);
-	}
-
-	//copy other's lights, updating transform pointers:
-	lights = other.lights;
-	for (auto &l : lights) {
-		l.transform = transform_to_transform.at(l.transform);
-	}
-}
@@ -1,7 +1,7 @@
 #pragma once
 
 /*
- * A scene manages a hierarchical arrangement of transformations (via "Transform").
+ * A scene manages a hierarchical arrangement of transformations (via "transforms").
  *
  * Each transformation may have associated:
  *  - Drawing data (via "Drawable")
@@ -11,48 +11,117 @@
  */
 
 #include "GL.hpp"
+#include "BVH.hpp"
+#include "gl_indirect.hpp"
+#include "InstanceAttributes.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
-#include <list>
 #include <memory>
 #include <functional>
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <limits>
+#include <cassert>
 
 struct Scene {
-	struct Transform {
+	//Transforms are referred to by their index in 'transforms':
+	static constexpr uint32_t NoTransform = -1U;
+
+	//All transforms are stored together, structure-of-arrays style, so that
+	// copying a scene is just copying a few vectors and updates are simple loops:
+	struct Transforms {
 		//Transform names are useful for debugging and looking up locations in a loaded scene:
-		std::string name;
+		std::vector< std::string > names;
 
 		//The core function of a transform is to store a transformation in the world:
-		glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
-		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f); //n.b. wxyz init order
-		glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f);
+		std::vector< glm::vec3 > positions;
+		std::vector< glm::quat > rotations; //n.b. wxyz init order
+		std::vector< glm::vec3 > scales;
 
 		//The transform above may be relative to some parent transform:
-		Transform *parent = nullptr;
+		// NOTE: transforms are kept in topological order -- parents[i] is always NoTransform or less than i
+		std::vector< uint32_t > parents;
+
+		uint32_t size() const { return uint32_t(positions.size()); }
+
+		//append a transform (identity, with the given name and parent) and return its index:
+		uint32_t add(std::string const &name = "", uint32_t parent = NoTransform);
 
-		//It is often convenient to construct matrices representing this transformation:
+		//It is often convenient to construct matrices representing a transformation:
 		// ..relative to its parent:
-		glm::mat4x3 make_parent_from_local() const;
-		glm::mat4x3 make_local_from_parent() const;
-		// ..relative to the world:
-		glm::mat4x3 make_world_from_local() const;
-		glm::mat4x3 make_local_from_world() const;
-
-		//since hierarchy is tracked through pointers, copy-constructing a transform  is not advised:
-		Transform(Transform const &) = delete;
-		//if we delete some constructors, we need to let the compiler know that the default constructor is still okay:
+		glm::mat4x3 make_parent_from_local(uint32_t index) const;
+		glm::mat4x3 make_local_from_parent(uint32_t index) const;
+		// ..relative to the world (computed up the parent chain; see world_from_local, below, for the cached version):
+		glm::mat4x3 make_world_from_local(uint32_t index) const;
+		glm::mat4x3 make_local_from_world(uint32_t index) const;
+
+		//Cached world_from_local matrices, brought up to date by update_world_from_local():
+		// (changes to positions/rotations/scales/parents are noticed automatically; nothing needs to be marked dirty)
+		// (changed matrices are recomputed in batches; see transform_batch.hpp)
+		mutable std::vector< glm::mat4x3 > world_from_local;
+		void update_world_from_local() const;
+
+		//internals: what each cached matrix was made from
+		struct Cached {
+			glm::vec3 position = glm::vec3(std::numeric_limits< float >::quiet_NaN()); //(NaN so the first update always computes)
+			glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			glm::vec3 scale = glm::vec3(1.0f);
+			uint32_t parent = NoTransform;
+		};
+		mutable std::vector< Cached > cached;
+		mutable std::vector< glm::mat4x3 > cached_parent_from_local;
+		mutable std::vector< uint8_t > cached_changed; //(during update: did this matrix change?)
+		mutable std::vector< uint32_t > cached_todo; //(during update: transforms to recompute; after: transforms whose world_from_local changed)
+	} transforms;
+
+	//A 'Transform' is a handle to one entry in 'transforms' that allows field-style access:
+	//  Scene::Transform rope = scene.transform(index);
+	//  rope->position = glm::vec3(1.0f, 2.0f, 3.0f);
+	// NOTE: the references returned by '->' are invalidated when transforms are added.
+	struct Transform {
 		Transform() = default;
+		Transform(Transforms *transforms_, uint32_t index_) : transforms(transforms_), index(index_) { }
+		Transforms *transforms = nullptr;
+		uint32_t index = NoTransform;
+
+		explicit operator bool() const { return transforms != nullptr && index != NoTransform; }
+
+		struct Fields {
+			std::string &name;
+			glm::vec3 &position;
+			glm::quat &rotation;
+			glm::vec3 &scale;
+		};
+		struct FieldsPointer {
+			Fields fields;
+			Fields *operator->() { return &fields; }
+		};
+		FieldsPointer operator->() const {
+			assert(*this);
+			return FieldsPointer{ Fields{
+				transforms->names[index],
+				transforms->positions[index],
+				transforms->rotations[index],
+				transforms->scales[index]
+			} };
+		}
 	};
+	Transform transform(uint32_t index) {
+		assert(index < transforms.size());
+		return Transform(&transforms, index);
+	}
 
 	struct Drawable {
 		//a 'Drawable' attaches attribute data to a transform:
-		Drawable(Transform *transform_) : transform(transform_) { assert(transform); }
-		Transform * transform;
+		Drawable(uint32_t transform_) : transform(transform_) { assert(transform != NoTransform); }
+		uint32_t transform; //index into transforms
+
+		//(optional) object-space bounding box, used by draw() to skip drawables that are out of view:
+		// (min > max -- the default -- means "no bounds"; the drawable is always drawn)
+		glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
 
 		//Contains all the data needed to run the OpenGL pipeline:
 		struct Pipeline {
@@ -64,14 +133,29 @@ struct Scene {
 			GLenum type = GL_TRIANGLES; //what sort of primitive to draw; passed to glDrawArrays
 			GLuint start = 0; //first vertex to draw; passed to glDrawArrays
 			GLuint count = 0; //number of vertices to draw; passed to glDrawArrays
+			GLenum index_type = GL_NONE; //if not GL_NONE, the vao has an element array of this type, start/count are a range of it, and drawing uses glDrawElements
 
 			//uniforms:
 			GLuint CLIP_FROM_OBJECT_mat4 = -1U; //uniform location for object to clip space matrix
 			GLuint LIGHT_FROM_OBJECT_mat4x3 = -1U; //uniform location for object to light space (== world space) matrix
 			GLuint LIGHT_FROM_NORMAL_mat3 = -1U; //uniform location for normal to light space (== world space) matrix
 
+			//..or, if set, the program reads those three matrices from an 'Object' uniform block (see Scene::ObjectUniforms):
+			bool object_block = false;
+
 			std::function< void() > set_uniforms; //(optional) function to set any other useful uniforms
 
+			//(optional) instanced version of this pipeline:
+			// when draw() finds several visible drawables with identical pipelines (and no set_uniforms), it draws
+			// them with one glDrawArraysInstanced using this program and vao instead, uploading each drawable's
+			// matrices (as a Scene::Instance) to 'buffer'. The vao should come from MeshBuffer::make_vao_for_program(program, buffer).
+			// (with multi-draw-indirect, drawables whose pipelines differ only in start/count are drawn together too)
+			struct Instanced {
+				GLuint program = 0; //shader program that reads CLIP_FROM_OBJECT, LIGHT_FROM_OBJECT, LIGHT_FROM_NORMAL as per-instance attributes
+				GLuint vao = 0; //same vertex attributes as 'vao', plus per-instance attributes sourced from 'buffer'
+				GLuint buffer = 0; //array buffer that per-instance data is uploaded to
+			} instanced;
+
 			//texture objects to bind for the first TextureCount textures:
 			enum : uint32_t { TextureCount = 4 };
 			struct TextureInfo {
@@ -81,10 +165,44 @@ struct Scene {
 		} pipeline;
 	};
 
+	//Per-instance data for instanced drawing (see Drawable::Pipeline::instanced):
+	using Instance = InstanceAttributes;
+
+	//Uniform blocks that draw() fills in for programs that declare them:
+	// 'Frame' is written once per draw() call; 'Object' once per drawable with pipeline.object_block set.
+	// Both live in one ring buffer, so per-drawable uniform setup is a single glBindBufferRange.
+	// Programs include the GLSL declarations below and point the blocks at these binding points with glUniformBlockBinding.
+	enum : GLuint { FrameBinding = 0, ObjectBinding = 1 };
+	static char const *FrameBlockGLSL;
+	static char const *ObjectBlockGLSL;
+
+	//C++ versions of the blocks (std140 layout: vec3s and matrix columns are padded to 16 bytes):
+	struct FrameUniforms {
+		glm::mat4 clip_from_world = glm::mat4(1.0f); //(set by draw())
+		//lighting, as used by LitColorTextureProgram:
+		glm::vec3 light_location = glm::vec3(0.0f);
+		int32_t light_type = 1; //0: point, 1: hemisphere, 2: spot, 3: directional
+		glm::vec3 light_direction = glm::vec3(0.0f, 0.0f,-1.0f);
+		float light_cutoff = 1.0f; //(cosine of spot light half-angle)
+		glm::vec3 light_energy = glm::vec3(1.0f);
+		float padding_ = 0.0f;
+	};
+	static_assert(sizeof(FrameUniforms) == 4*16 + 3*16, "FrameUniforms matches std140 layout.");
+
+	struct ObjectUniforms {
+		glm::mat4 clip_from_object;
+		glm::vec4 light_from_object[4]; //(mat4x3 columns)
+		glm::vec4 light_from_normal[3]; //(mat3 columns)
+	};
+	static_assert(sizeof(ObjectUniforms) == 4*16 + 4*16 + 3*16, "ObjectUniforms matches std140 layout.");
+
+	//per-frame values for the 'Frame' block (draw() fills in clip_from_world):
+	FrameUniforms frame_uniforms;
+
 	struct Camera {
 		//a 'Camera' attaches camera data to a transform:
-		Camera(Transform *transform_) : transform(transform_) { assert(transform); }
-		Transform * transform;
+		Camera(uint32_t transform_) : transform(transform_) { assert(transform != NoTransform); }
+		uint32_t transform; //index into transforms
 		//NOTE: cameras are directed along their -z axis
 
 		//perspective camera parameters:
@@ -97,8 +215,8 @@ struct Scene {
 
 	struct Light {
 		//a 'Light' attaches light data to a transform:
-		Light(Transform *transform_) : transform(transform_) { assert(transform); }
-		Transform * transform;
+		Light(uint32_t transform_) : transform(transform_) { assert(transform != NoTransform); }
+		uint32_t transform; //index into transforms
 		//NOTE: directional, spot, and hemisphere lights are directed along their -z axis
 
 		enum Type : char {
@@ -117,37 +235,104 @@ struct Scene {
 	};
 
 	//Scenes, of course, may have many of the above objects:
-	std::list< Transform > transforms;
-	std::list< Drawable > drawables;
-	std::list< Camera > cameras;
-	std::list< Light > lights;
+	// (transforms are stored above)
+	std::vector< Drawable > drawables;
+	std::vector< Camera > cameras;
+	std::vector< Light > lights;
+
+	//Bring every transform's cached world_from_local matrix up to date in a single parents-first pass:
+	// (draw() calls this, so you only need to if you want the matrices for something else)
+	// (also keeps drawable_bvh in sync, so call this rather than transforms.update_world_from_local())
+	void update_world_from_local() const;
+
+	//Index of the drawable whose world-space bounding box is hit first by the ray origin + t * direction (t >= 0):
+	// returns -1U if none is hit; sets *t to where the ray enters the box
+	// (only drawables with bounds can be picked; positions are as of the last draw() or update_world_from_local())
+	uint32_t pick(glm::vec3 const &origin, glm::vec3 const &direction, float *t = nullptr) const;
+
+	//Adding or removing drawables is noticed automatically, but if you change
+	// an existing drawable's transform or bounds, call this so culling sees it:
+	void drawables_changed() { drawable_bvh.stale = true; }
 
 	//The "draw" function provides a convenient way to pass all the things in a scene to OpenGL:
+	// (camera must be attached to a transform in this scene)
 	void draw(Camera const &camera) const;
 
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
 	void draw(glm::mat4 const &clip_from_world, glm::mat4x3 const &light_from_world = glm::mat4x3(1.0f)) const;
 
+	//draw() skips drawables whose bounds are out of view (using drawable_bvh), draws the rest in 'drawables' order, and skips redundant binds;
+	// runs of drawables with identical pipelines that have an instanced version are drawn with one call each.
+	//set this to true to sort by (program, vertex array, textures, depth) first, which makes for fewer binds and longer runs --
+	// but only do so if draw order doesn't matter (e.g., nothing is blended):
+	bool sort_drawables = false;
+
+	//when the GL supports it (see gl_indirect.hpp), runs of instanceable drawables that share everything but their meshes
+	// are drawn with one glMultiDrawArraysIndirect; set this to false to use a glDrawArraysInstanced per mesh instead:
+	bool multi_draw_indirect = true;
+
+	//counts from the most recent draw():
+	struct DrawStats {
+		uint32_t draws = 0; //drawables drawn
+		uint32_t draw_calls = 0; //glDrawArrays* calls made (fewer than 'draws' when drawables are instanced)
+		uint32_t instanced = 0; //drawables drawn as part of an instanced batch
+		uint32_t indirect_commands = 0; //draws issued through glMultiDrawArraysIndirect (each one mesh, one or more instances)
+		uint32_t culled = 0; //drawables skipped because their bounds were outside the view frustum
+		uint32_t state_changes = 0; //program, vertex array, and texture binds made
+		uint32_t state_changes_avoided = 0; //binds skipped, compared to binding everything for every drawable
+	};
+	mutable DrawStats draw_stats;
+
+	//internals: draw() queue
+	struct DrawItem {
+		uint64_t key;
+		uint32_t drawable; //index into drawables
+	};
+	mutable std::vector< DrawItem > draw_queue, draw_queue_scratch;
+	mutable std::vector< uint32_t > draw_visible;
+	mutable std::vector< Instance > draw_instances;
+	mutable std::vector< DrawArraysIndirectCommand > draw_commands;
+	mutable std::vector< DrawElementsIndirectCommand > draw_element_commands;
+	struct DrawBatch {
+		uint32_t begin, count; //range of draw_queue drawn together (count > 1 means instanced, possibly multi-draw-indirect)
+		uint32_t object; //index of this drawable's 'Object' block in this frame's uniforms, or -1U
+	};
+	mutable std::vector< DrawBatch > draw_batches;
+
+	//internals: BVH over the world-space bounds of drawables (for culling and picking)
+	// rebuilt when drawables or transforms are added or removed; refit when transforms move
+	struct DrawableBVH {
+		BVH bvh;
+		std::vector< uint32_t > drawables; //bvh item -> index into drawables
+		std::vector< uint32_t > unbounded; //drawables without bounds (never culled)
+		std::vector< uint32_t > by_transform_begin; //by_transform[by_transform_begin[t] .. by_transform_begin[t+1]) are the bvh items on transform t
+		std::vector< uint32_t > by_transform;
+		size_t drawable_count = 0;
+		uint32_t transform_count = 0;
+		bool stale = true;
+	};
+	mutable DrawableBVH drawable_bvh;
+
 	//add transforms/objects/cameras from a scene file to this scene:
 	// the 'on_drawable' callback gives your code a chance to look up mesh data and make Drawables:
 	// throws on file format errors
 	void load(std::string const &filename,
-		std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable = nullptr
+		std::function< void(Scene &, uint32_t transform, std::string const &) > const &on_drawable = nullptr
 	);
 
 	//this function is called to read extra chunks from the scene file after the main chunks are read:
 	// this is useful if you, e.g., subclassing scene to represent a game level/area
-	virtual void load_extra(std::istream &from, std::vector< char > const &str0, std::vector< Transform * > const &xfh0) { }
+	// (entry i of the file's xfh0 chunk is transform xfh0_begin + i)
+	virtual void load_extra(std::istream &from, std::vector< char > const &str0, uint32_t xfh0_begin) { }
 
 	//empty scene:
 	Scene() = default;
 
 	//load a scene:
-	Scene(std::string const &filename, std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable);
+	Scene(std::string const &filename, std::function< void(Scene &, uint32_t transform, std::string const &) > const &on_drawable);
 
-	//copy a scene (with proper pointer fixup):
-	Scene(Scene const &); //...as a constructor
-	Scene &operator=(Scene const &); //...as scene = scene
-	//... as a set() function that optionally returns the transform->transform mapping:
-	void set(Scene const &, std::unordered_map< Transform const *, Transform * > *transform_map = nullptr);
+	//since objects refer to transforms by index, scenes can be copied directly:
+	Scene(Scene const &) = default;
+	Scene &operator=(Scene const &) = default;
+	virtual ~Scene() = default;
 };
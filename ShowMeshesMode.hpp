@@ -43,5 +43,6 @@ struct ShowMeshesMode : Mode {
 	//mode uses a small Scene to arrange things for viewing:
 	Scene scene;
 	Scene::Camera *scene_camera = nullptr;
+	Scene::Transform scene_camera_transform; //(handle for scene_camera->transform)
 	Scene::Drawable *scene_drawable = nullptr;
 };
@@ -5,8 +5,8 @@
 
 Scene::Drawable::Pipeline show_meshes_program_pipeline;
 
-Load< ShowMeshesProgram > show_meshes_program(LoadTagEarly, []() -> ShowMeshesProgram * {
-	auto *ret = new ShowMeshesProgram();
+Load< ShowMeshesProgram > show_meshes_program(LoadTagEarly, LoadSubmitFirst(), ShowMeshesProgram::submit, [](GLProgramBuild &&build) -> ShowMeshesProgram * {
+	auto *ret = new ShowMeshesProgram(std::move(build));
 
 	show_meshes_program_pipeline.program = ret->program;
 
@@ -17,9 +17,10 @@ Load< ShowMeshesProgram > show_meshes_program(LoadTagEarly, []() -> ShowMeshesPr
 	return ret;
 });
 
-ShowMeshesProgram::ShowMeshesProgram() {
-	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
-	program = gl_compile_program(
+GLProgramBuild ShowMeshesProgram::submit() {
+	//Start compiling vertex and fragment shaders using the convenient 'gl_submit_program' helper function:
+	// (the constructor waits for the result)
+	return gl_submit_program(
 		//vertex shader:
 		"#version 330\n"
 		"uniform mat4 CLIP_FROM_OBJECT;\n"
@@ -72,6 +73,12 @@ ShowMeshesProgram::ShowMeshesProgram() {
 		"	}\n"
 		"}\n"
 	);
+}
+
+ShowMeshesProgram::ShowMeshesProgram(GLProgramBuild &&build) {
+	//wait for the shaders submitted by submit() to finish compiling:
+	program = gl_await_program(std::move(build));
+
 
 	//look up the locations of vertex attributes:
 	Position_vec4 = glGetAttribLocation(program, "Position");
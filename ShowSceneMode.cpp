@@ -7,9 +7,9 @@ ShowSceneMode::ShowSceneMode(Scene const &scene_) : scene(scene_) {
 
 	//Set up camera-only scene:
 	{ //create a single camera:
-		camera_scene.transforms.emplace_back();
-		camera_scene.cameras.emplace_back(&camera_scene.transforms.back());
+		camera_scene.cameras.emplace_back(camera_scene.transforms.add("camera"));
 		scene_camera = &camera_scene.cameras.back();
+		scene_camera_transform = camera_scene.transform(scene_camera->transform);
 		scene_camera->fovy = 60.0f / 180.0f * 3.1415926f;
 		scene_camera->near = 0.01f;
 		//scene_camera->transform and scene_camera->aspect will be set in draw()
@@ -40,7 +40,7 @@ bool ShowSceneMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_
 			if (SDL_GetModState() & SDL_KMOD_SHIFT) {
 				//shift: pan
 
-				glm::mat3 frame = glm::mat3_cast(scene_camera->transform->rotation);
+				glm::mat3 frame = glm::mat3_cast(scene_camera_transform->rotation);
 				camera.target -= frame[0] * (delta.x * camera.radius) + frame[1] * (delta.y * camera.radius);
 			} else {
 				//no shift: tumble
@@ -75,12 +75,12 @@ bool ShowSceneMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_
 void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 	//--- use camera structure to set up scene camera ---
 
-	scene_camera->transform->rotation =
+	scene_camera_transform->rotation =
 		glm::angleAxis(camera.azimuth, glm::vec3(0.0f, 0.0f, 1.0f))
 		* glm::angleAxis(0.5f * 3.1415926f + -camera.elevation, glm::vec3(1.0f, 0.0f, 0.0f))
 	;
-	scene_camera->transform->position = camera.target + camera.radius * (scene_camera->transform->rotation * glm::vec3(0.0f, 0.0f, 1.0f));
-	scene_camera->transform->scale = glm::vec3(1.0f);
+	scene_camera_transform->position = camera.target + camera.radius * (scene_camera_transform->rotation * glm::vec3(0.0f, 0.0f, 1.0f));
+	scene_camera_transform->scale = glm::vec3(1.0f);
 	scene_camera->aspect = float(drawable_size.x) / float(drawable_size.y);
 
 
@@ -91,12 +91,16 @@ void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LEQUAL);
 
-	scene.draw(*scene_camera);
+	//(camera lives in camera_scene, so pass scene the matrix directly)
+	glm::mat4 clip_from_world = scene_camera->make_projection() * glm::mat4(camera_scene.transforms.make_local_from_world(scene_camera->transform));
+	scene.draw(clip_from_world);
 
 	{ //decorate with some lines:
-		DrawLines draw_lines(scene_camera->make_projection() * glm::mat4(scene_camera->transform->make_local_from_world()));
-		for (auto &transform : scene.transforms) {
-			glm::mat4 world_from_local = transform.make_world_from_local();
+		DrawLines draw_lines(clip_from_world);
+		Scene::Transforms const &transforms = scene.transforms;
+		//(draw() brought transforms.world_from_local up to date)
+		for (uint32_t i = 0; i < transforms.size(); ++i) {
+			glm::mat4 world_from_local = transforms.world_from_local[i];
 			auto xf = [&world_from_local](glm::vec3 const &vec) {
 				return glm::vec3(world_from_local * glm::vec4(vec, 1.0f));
 			};
@@ -104,9 +108,9 @@ void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 				return glm::vec3(world_from_local * glm::vec4(vec, 0.0f));
 			};
 
-			if (transform.parent) {
+			if (transforms.parents[i] != Scene::NoTransform) {
 				//connect to parent:
-				glm::vec3 p = glm::vec3(transform.parent->make_world_from_local()[3]);
+				glm::vec3 p = glm::vec3(transforms.world_from_local[transforms.parents[i]][3]);
 				draw_lines.draw(p, xf(glm::vec3(0.0f)), glm::u8vec4(0xff, 0xff, 0x00, 0xff));
 			}
 
@@ -121,7 +125,7 @@ void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 			draw_lines.draw(xf(glm::vec3(0.0f)), xf(glm::vec3(0.0f, 0.0f, -len)), glm::u8vec4(0x00, 0x00, 0x88, 0xff));
 
 			//transform name:
-			draw_lines.draw_text("'" + transform.name + "'",
+			draw_lines.draw_text("'" + transforms.names[i] + "'",
 				xf(glm::vec3(0.05f, 0.0f, 0.05f)),
 				0.15f * xfd(glm::vec3(1.0f, 0.0f, 0.0f)),
 				0.15f * xfd(glm::vec3(0.0f, 0.0f, 1.0f)),
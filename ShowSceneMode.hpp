@@ -33,4 +33,5 @@ struct ShowSceneMode : Mode {
 	//mode uses a secondary Scene to hold a camera:
 	Scene camera_scene;
 	Scene::Camera *scene_camera = nullptr;
+	Scene::Transform scene_camera_transform; //(handle for scene_camera->transform)
 };
@@ -5,8 +5,8 @@
 
 Scene::Drawable::Pipeline show_scene_program_pipeline;
 
-Load< ShowSceneProgram > show_scene_program(LoadTagEarly, []() -> ShowSceneProgram * {
-	auto *ret = new ShowSceneProgram();
+Load< ShowSceneProgram > show_scene_program(LoadTagEarly, LoadSubmitFirst(), ShowSceneProgram::submit, [](GLProgramBuild &&build) -> ShowSceneProgram * {
+	auto *ret = new ShowSceneProgram(std::move(build));
 
 	show_scene_program_pipeline.program = ret->program;
 
@@ -17,9 +17,10 @@ Load< ShowSceneProgram > show_scene_program(LoadTagEarly, []() -> ShowSceneProgr
 	return ret;
 });
 
-ShowSceneProgram::ShowSceneProgram() {
-	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
-	program = gl_compile_program(
+GLProgramBuild ShowSceneProgram::submit() {
+	//Start compiling vertex and fragment shaders using the convenient 'gl_submit_program' helper function:
+	// (the constructor waits for the result)
+	return gl_submit_program(
 		//vertex shader:
 		"#version 330\n"
 		"uniform mat4 CLIP_FROM_OBJECT;\n"
@@ -72,6 +73,12 @@ ShowSceneProgram::ShowSceneProgram() {
 		"	}\n"
 		"}\n"
 	);
+}
+
+ShowSceneProgram::ShowSceneProgram(GLProgramBuild &&build) {
+	//wait for the shaders submitted by submit() to finish compiling:
+	program = gl_await_program(std::move(build));
+
 
 	//look up the locations of vertex attributes:
 	Position_vec4 = glGetAttribLocation(program, "Position");
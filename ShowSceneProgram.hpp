@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GL.hpp"
+#include "gl_compile_program.hpp"
 #include "Load.hpp"
 
 #include "Scene.hpp"
@@ -8,7 +9,9 @@
 //Shader program that provides various modes for visualizing positions,
 // colors, normals, and texture coordinates; mostly useful for debugging.
 struct ShowSceneProgram {
-	ShowSceneProgram();
+	//start compiling the shaders (see gl_submit_program); the constructor waits for them to finish:
+	static GLProgramBuild submit();
+	ShowSceneProgram(GLProgramBuild &&build = submit());
 	~ShowSceneProgram();
 
 	GLuint program = 0;
@@ -90,40 +90,50 @@ void Sound::unlock() {
 	if (stream) SDL_UnlockAudioStream(stream);
 }
 
-std::shared_ptr< Sound::PlayingSample > Sound::play(Sample const &sample, float play_volume, float pan) {
-	std::shared_ptr< Sound::PlayingSample > playing_sample = std::make_shared< Sound::PlayingSample >(sample, play_volume, pan, false);
-	lock();
+//shared by all the play/loop functions below;
+// 'where' is the pan (2D) or the position and half-volume radius (3D), and 'holding' (if set) keeps the sample alive while it plays:
+template< typename... Where >
+static std::shared_ptr< Sound::PlayingSample > start_playing(Sound::Sample const &sample, std::shared_ptr< Sound::Sample const > const &holding, float play_volume, bool loop, Where const &... where) {
+	std::shared_ptr< Sound::PlayingSample > playing_sample = std::make_shared< Sound::PlayingSample >(sample, play_volume, where..., loop);
+	playing_sample->holding = holding;
+	Sound::lock();
 	playing_samples.emplace_back(playing_sample);
-	unlock();
+	Sound::unlock();
 	return playing_sample;
 }
 
+std::shared_ptr< Sound::PlayingSample > Sound::play(Sample const &sample, float play_volume, float pan) {
+	return start_playing(sample, nullptr, play_volume, false, pan);
+}
+
 std::shared_ptr< Sound::PlayingSample > Sound::play_3D(Sample const &sample, float play_volume, glm::vec3 const &position, float half_volume_radius) {
-	std::shared_ptr< Sound::PlayingSample > playing_sample = std::make_shared< Sound::PlayingSample >(sample, play_volume, position, half_volume_radius, false);
-	lock();
-	playing_samples.emplace_back(playing_sample);
-	unlock();
-	return playing_sample;
+	return start_playing(sample, nullptr, play_volume, false, position, half_volume_radius);
 }
 
 std::shared_ptr< Sound::PlayingSample > Sound::loop(Sample const &sample, float play_volume, float pan) {
-	std::shared_ptr< Sound::PlayingSample > playing_sample = std::make_shared< Sound::PlayingSample >(sample, play_volume, pan, true);
-	lock();
-	playing_samples.emplace_back(playing_sample);
-	unlock();
-	return playing_sample;
+	return start_playing(sample, nullptr, play_volume, true, pan);
 }
 
+std::shared_ptr< Sound::PlayingSample > Sound::loop_3D(Sample const &sample, float play_volume, glm::vec3 const &position, float half_volume_radius) {
+	return start_playing(sample, nullptr, play_volume, true, position, half_volume_radius);
+}
 
+//shared_ptr versions: same as above, but the playing sample holds on to the sample:
+std::shared_ptr< Sound::PlayingSample > Sound::play(std::shared_ptr< Sample const > const &sample, float play_volume, float pan) {
+	return start_playing(*sample, sample, play_volume, false, pan);
+}
 
-std::shared_ptr< Sound::PlayingSample > Sound::loop_3D(Sample const &sample, float play_volume, glm::vec3 const &position, float half_volume_radius) {
-	std::shared_ptr< Sound::PlayingSample > playing_sample = std::make_shared< Sound::PlayingSample >(sample, play_volume, position, half_volume_radius, true);
-	lock();
-	playing_samples.emplace_back(playing_sample);
-	unlock();
-	return playing_sample;
+std::shared_ptr< Sound::PlayingSample > Sound::play_3D(std::shared_ptr< Sample const > const &sample, float play_volume, glm::vec3 const &position, float half_volume_radius) {
+	return start_playing(*sample, sample, play_volume, false, position, half_volume_radius);
 }
 
+std::shared_ptr< Sound::PlayingSample > Sound::loop(std::shared_ptr< Sample const > const &sample, float play_volume, float pan) {
+	return start_playing(*sample, sample, play_volume, true, pan);
+}
+
+std::shared_ptr< Sound::PlayingSample > Sound::loop_3D(std::shared_ptr< Sample const > const &sample, float play_volume, glm::vec3 const &position, float half_volume_radius) {
+	return start_playing(*sample, sample, play_volume, true, position, half_volume_radius);
+}
 
 void Sound::stop_all_samples() {
 	lock();
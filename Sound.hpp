@@ -67,6 +67,7 @@ struct PlayingSample {
 	//NOTE: PlayingSample is used in a separate thread; so setting these values directly
 	// may result in bad results. Instead, use the functions above, which perform locking!
 	std::vector< float > const &data; //reference to sample data being played
+	std::shared_ptr< Sample const > holding; //(for samples played from a shared_ptr) keeps 'data' alive
 	uint32_t i = 0; //next data value to read
 	bool loop = false; //should playback loop after data runs out?
 	bool stopping = false; //is playing stopping?
@@ -123,6 +124,13 @@ std::shared_ptr< PlayingSample > loop_3D(
 	float half_volume_radius = std::numeric_limits< float >::infinity()
 );
 
+//Versions of the above for samples held by shared_ptr (e.g., from a Resident< Sample >, see Residency.hpp);
+// these keep the sample alive (and so, resident) while it plays:
+std::shared_ptr< PlayingSample > play(std::shared_ptr< Sample const > const &sample, float volume = 1.0f, float pan = 0.0f);
+std::shared_ptr< PlayingSample > play_3D(std::shared_ptr< Sample const > const &sample, float volume, glm::vec3 const &position, float half_volume_radius = std::numeric_limits< float >::infinity());
+std::shared_ptr< PlayingSample > loop(std::shared_ptr< Sample const > const &sample, float volume = 1.0f, float pan = 0.0f);
+std::shared_ptr< PlayingSample > loop_3D(std::shared_ptr< Sample const > const &sample, float volume, glm::vec3 const &position, float half_volume_radius = std::numeric_limits< float >::infinity());
+
 //Listener controls the panning of "3D" samples (ones played using the "position" version of the play functions):
 struct Listener {
 	void set_position_right(glm::vec3 const &new_position, glm::vec3 const &new_right, float ramp = 1.0f / 60.0f);
@@ -0,0 +1,74 @@
+#include "StreamRing.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+StreamRing::StreamRing(GLenum target_, GLsizeiptr alignment_) : target(target_), alignment(alignment_) {
+}
+
+void StreamRing::create() {
+	if (buffer != 0) return;
+	glGenBuffers(1, &buffer);
+	if (target == GL_UNIFORM_BUFFER) {
+		//(ranges bound with glBindBufferRange must start at multiples of this)
+		GLint value = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+		alignment = std::max< GLsizeiptr >(alignment, value);
+	}
+}
+
+void StreamRing::orphan() {
+	glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+	for (Fence &fence : fences) glDeleteSync(fence.sync);
+	fences.clear();
+	head = 0;
+}
+
+char *StreamRing::map(GLsizeiptr bytes, GLsizeiptr *offset) {
+	create();
+	glBindBuffer(target, buffer);
+
+	bytes = align(bytes);
+	if (3 * bytes > size) {
+		//grow to fit a few frames in flight:
+		size = std::max(std::max(3 * bytes, 2 * size), GLsizeiptr(1 << 20));
+		orphan();
+	}
+	if (head + bytes > size) head = 0;
+
+	//wait for the GPU to finish reading earlier ranges that overlap this one:
+	// (fences signal in order, so everything older than the newest overlapping fence is done too)
+	uint32_t done = 0;
+	for (uint32_t i = 0; i < fences.size(); ++i) {
+		if (fences[i].begin < head + bytes && head < fences[i].end) done = i + 1;
+	}
+	if (done) {
+		GLenum result = glClientWaitSync(fences[done - 1].sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL /* 1s, in ns */);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+			for (uint32_t i = 0; i < done; ++i) glDeleteSync(fences[i].sync);
+			fences.erase(fences.begin(), fences.begin() + done);
+		} else {
+			//timed out (or the wait failed), so the GPU may still be reading the range;
+			// rather than write over it, start again in fresh storage:
+			orphan();
+		}
+	}
+
+	void *ptr = glMapBufferRange(target, head, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!ptr) throw std::runtime_error("Failed to map stream buffer range.");
+
+	*offset = head;
+	mapped_begin = head;
+	mapped_end = head + bytes;
+	head = mapped_end;
+	return reinterpret_cast< char * >(ptr);
+}
+
+void StreamRing::unmap() {
+	glUnmapBuffer(target);
+	glBindBuffer(target, 0);
+}
+
+void StreamRing::fence() {
+	fences.emplace_back(Fence{ mapped_begin, mapped_end, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+}
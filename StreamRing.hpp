@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+ * A StreamRing is a GL buffer that per-frame data (uniform blocks, overlay
+ *  vertices, ...) is streamed into, used as a ring:
+ *
+ *   GLsizeiptr offset;
+ *   char *data = ring.map(bytes, &offset); //leaves ring.buffer bound to ring.target
+ *   //...write 'bytes' bytes to 'data'...
+ *   ring.unmap();
+ *   //...draw using [offset, offset + bytes) of ring.buffer...
+ *   ring.fence();
+ *
+ * Each map() takes the next unused range, mapped unsynchronized (so the
+ *  driver doesn't wait on the GPU); fence() marks when the GPU is done with
+ *  the range, so a range is only waited on (rarely) once the ring wraps back
+ *  around to it. The ring grows to hold a few frames' worth of data.
+ *
+ * (persistent mapping would avoid the map/unmap, but needs GL 4.4)
+ */
+
+#include "GL.hpp"
+
+#include <vector>
+
+struct StreamRing {
+	//'alignment': ranges start at multiples of this;
+	// for GL_UNIFORM_BUFFER it is raised to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT if needed.
+	StreamRing(GLenum target, GLsizeiptr alignment);
+
+	StreamRing(StreamRing const &) = delete;
+	StreamRing &operator=(StreamRing const &) = delete;
+
+	//make 'buffer' if it doesn't exist yet (e.g., to set up vaos before the first map()):
+	void create();
+
+	//size of a 'bytes'-byte range (rounded up to 'alignment'):
+	GLsizeiptr align(GLsizeiptr bytes) const { return (bytes + alignment - 1) / alignment * alignment; }
+
+	//map 'bytes' bytes for writing (leaves 'buffer' bound to 'target'); sets *offset to where they start:
+	// note: will throw if the range can't be mapped
+	char *map(GLsizeiptr bytes, GLsizeiptr *offset);
+	//unmap (and unbind) after writing:
+	void unmap();
+	//call after the draws that read the mapped range:
+	void fence();
+
+	GLenum target;
+	GLsizeiptr alignment;
+	GLuint buffer = 0;
+
+	//-- internals --
+	GLsizeiptr size = 0;
+	GLsizeiptr head = 0; //where the next range starts
+
+	struct Fence {
+		GLsizeiptr begin, end;
+		GLsync sync;
+	};
+	std::vector< Fence > fences; //oldest first
+	GLsizeiptr mapped_begin = 0, mapped_end = 0;
+
+	//start again in fresh storage (earlier ranges no longer matter):
+	void orphan();
+};
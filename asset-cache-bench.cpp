@@ -0,0 +1,120 @@
+//asset-cache-bench: how much startup time does the asset cache save?
+//
+// Loads each file three ways and reports milliseconds for:
+//  - 'uncached': converting from the source format with the cache turned off
+//  - 'cold': first load with an empty cache (convert + write blob)
+//  - 'warm': load again from the cached blob
+// Checks that all three give the same data.
+//
+// Files ending in .opus / .wav are loaded as audio, .png as images.
+
+#include "asset_cache.hpp"
+#include "load_opus.hpp"
+#include "load_wav.hpp"
+#include "load_save_png.hpp"
+#include "data_path.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	std::vector< std::string > files;
+	for (int i = 1; i < argc; ++i) {
+		files.emplace_back(argv[i]);
+	}
+	if (files.empty()) {
+		files.emplace_back(data_path("../dist/dusty-floor.opus"));
+		files.emplace_back(data_path("../dist/honk.wav"));
+
+		//make a test image, since there are no PNGs in dist/:
+		std::string png = (std::filesystem::temp_directory_path() / "asset-cache-bench.png").string();
+		glm::uvec2 size(1024, 1024);
+		std::vector< glm::u8vec4 > pixels(size.x * size.y);
+		for (uint32_t y = 0; y < size.y; ++y) {
+			for (uint32_t x = 0; x < size.x; ++x) {
+				pixels[y * size.x + x] = glm::u8vec4(x ^ y, x * 3, y * 5, 0xff);
+			}
+		}
+		save_png(png, size, pixels.data(), LowerLeftOrigin);
+		files.emplace_back(png);
+	}
+
+	std::string cache_dir = (std::filesystem::temp_directory_path() / "asset-cache-bench").string();
+	std::filesystem::remove_all(cache_dir);
+
+	//load a file; returns its contents as bytes (for comparing):
+	auto load = [](std::string const &file) {
+		std::vector< char > bytes;
+		auto ends_with = [&](std::string const &suffix) {
+			return file.size() >= suffix.size() && file.substr(file.size() - suffix.size()) == suffix;
+		};
+		if (ends_with(".opus") || ends_with(".wav")) {
+			std::vector< float > data;
+			if (ends_with(".opus")) load_opus(file, &data);
+			else load_wav(file, &data);
+			bytes.assign(reinterpret_cast< char const * >(data.data()), reinterpret_cast< char const * >(data.data() + data.size()));
+		} else if (ends_with(".png")) {
+			glm::uvec2 size;
+			std::vector< glm::u8vec4 > data;
+			load_png(file, &size, &data, LowerLeftOrigin);
+			bytes.assign(reinterpret_cast< char const * >(data.data()), reinterpret_cast< char const * >(data.data() + data.size()));
+		} else {
+			throw std::runtime_error("Not sure how to load '" + file + "'.");
+		}
+		return bytes;
+	};
+
+	auto time = [](auto const &fn) {
+		auto before = std::chrono::high_resolution_clock::now();
+		fn();
+		return std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+	};
+
+	struct Row {
+		std::string file;
+		size_t bytes;
+		double uncached, cold, warm;
+	};
+	std::vector< Row > rows;
+	for (auto const &file : files) {
+		Row row;
+		row.file = file.substr(file.find_last_of("/\\") + 1);
+		std::vector< char > uncached, cold, warm;
+
+		asset_cache_dir = "";
+		row.uncached = time([&]() { uncached = load(file); });
+
+		asset_cache_dir = cache_dir;
+		row.cold = time([&]() { cold = load(file); });
+		row.warm = time([&]() { warm = load(file); });
+
+		if (cold != uncached || warm != uncached) {
+			std::cerr << "Cached data for '" << file << "' doesn't match!" << std::endl;
+			return 1;
+		}
+		row.bytes = uncached.size();
+		rows.emplace_back(row);
+	}
+	std::filesystem::remove_all(cache_dir);
+
+	std::cout << "asset-cache-bench: times in milliseconds." << std::endl;
+	std::cout << std::setw(28) << "file" << std::setw(12) << "bytes"
+	          << std::setw(10) << "uncached" << std::setw(10) << "cold" << std::setw(10) << "warm" << std::endl;
+	double total_uncached = 0.0, total_warm = 0.0;
+	for (auto const &row : rows) {
+		std::cout << std::setw(28) << row.file << std::setw(12) << row.bytes
+		          << std::setw(10) << std::setprecision(4) << 1e3 * row.uncached
+		          << std::setw(10) << std::setprecision(4) << 1e3 * row.cold
+		          << std::setw(10) << std::setprecision(4) << 1e3 * row.warm << std::endl;
+		total_uncached += row.uncached;
+		total_warm += row.warm;
+	}
+	std::cout << "startup (all files): " << std::setprecision(4) << 1e3 * total_uncached << "ms uncached, "
+	          << 1e3 * total_warm << "ms warm." << std::endl;
+
+	return 0;
+}
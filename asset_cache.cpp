@@ -0,0 +1,122 @@
+#include "asset_cache.hpp"
+
+#include "data_path.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <cstring>
+
+std::string asset_cache_dir = data_path("asset-cache");
+
+uint64_t hash_bytes(void const *data_, size_t size, uint64_t seed) {
+	//eight bytes at a time through a multiply-xorshift mix (the same idea as xxHash/wyhash, much less tuned):
+	auto mix = [](uint64_t h) {
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	};
+	unsigned char const *data = reinterpret_cast< unsigned char const * >(data_);
+	uint64_t h = seed ^ (size * 0x9e3779b97f4a7c15ULL);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		h = (h ^ mix(word)) * 0x9e3779b97f4a7c15ULL;
+	}
+	uint64_t tail = 0;
+	if (i < size) std::memcpy(&tail, data + i, size - i);
+	h = (h ^ mix(tail)) * 0x9e3779b97f4a7c15ULL;
+	return mix(h);
+}
+
+static std::filesystem::path blob_path(uint64_t key) {
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << key << ".blob";
+	return std::filesystem::path(asset_cache_dir) / name.str();
+}
+
+std::unique_ptr< MappedFile > cached_asset(std::string const &source, std::string const &converter, uint32_t version,
+	std::function< void(std::ostream &) > const &convert) {
+
+	if (asset_cache_dir.empty()) return cached_blob(0, source, convert);
+
+	//key: hash of the source file's contents + converter + version:
+	uint64_t key;
+	{
+		MappedFile file(source);
+		key = hash_bytes(file.data, file.size);
+	}
+	key = hash_bytes(converter.data(), converter.size(), key);
+	key = hash_bytes(&version, sizeof(version), key);
+
+	return cached_blob(key, source, convert);
+}
+
+std::unique_ptr< MappedFile > cached_blob(uint64_t key, std::string const &source,
+	std::function< void(std::ostream &) > const &convert) {
+
+	//converts to memory without touching the cache (used when the cache is off or can't be written):
+	auto uncached = [&]() {
+		std::ostringstream out;
+		convert(out);
+		std::string bytes = out.str();
+		return std::make_unique< MappedFile >(source, std::vector< uint8_t >(bytes.begin(), bytes.end()));
+	};
+
+	if (asset_cache_dir.empty()) return uncached();
+
+	std::filesystem::path path = blob_path(key);
+
+	std::error_code ec;
+	if (!std::filesystem::exists(path, ec)) {
+		//write to a temporary name and then rename into place, so other loaders never see a half-written blob:
+		std::filesystem::path temp = path;
+		temp += ".tmp" + std::to_string(std::hash< std::thread::id >()(std::this_thread::get_id()));
+		std::filesystem::create_directories(asset_cache_dir, ec);
+		{
+			std::ofstream out(temp, std::ios::binary);
+			if (!out) {
+				std::cerr << "WARNING: can't write to asset cache '" << asset_cache_dir << "'; converting '" << source << "' without caching." << std::endl;
+				return uncached();
+			}
+			try {
+				convert(out);
+			} catch (...) {
+				out.close();
+				std::filesystem::remove(temp, ec);
+				throw;
+			}
+			if (!out) {
+				out.close();
+				std::filesystem::remove(temp, ec);
+				throw std::runtime_error("Failed to write cached asset '" + temp.string() + "'.");
+			}
+		}
+		std::filesystem::rename(temp, path, ec);
+		if (ec) { //(e.g., another loader got there first and the blob is in use)
+			std::filesystem::remove(temp, ec);
+		}
+	}
+	return std::make_unique< MappedFile >(path.string(), MappedFile::FileOnly());
+}
+
+std::unique_ptr< MappedFile > find_cached_blob(uint64_t key) {
+	if (asset_cache_dir.empty()) return nullptr;
+	std::filesystem::path path = blob_path(key);
+	std::error_code ec;
+	if (!std::filesystem::exists(path, ec)) return nullptr;
+	return std::make_unique< MappedFile >(path.string(), MappedFile::FileOnly());
+}
+
+void forget_cached_blob(uint64_t key) {
+	if (asset_cache_dir.empty()) return;
+	std::error_code ec;
+	std::filesystem::remove(blob_path(key), ec);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * An on-disk cache of preprocessed assets (decoded audio, expanded images,
+ *  ...), so the expensive conversion from the source format only happens
+ *  the first time a given file is loaded.
+ *
+ * Cached blobs are chunk files (see read_write_chunk.hpp) named by a hash
+ *  of the source file's contents plus the converter's name and version, so
+ *  editing a source file (or bumping a converter's version when its output
+ *  changes) just makes a new blob; stale ones are never looked at again.
+ *
+ * Blobs are memory-mapped when loaded, so reading one is about as cheap as
+ *  copying its bytes out.
+ *
+ * Example (see load_opus.cpp):
+ *   std::unique_ptr< MappedFile > blob = cached_asset(filename, "opus-f32-48k-mono", 1, [&](std::ostream &out) {
+ *       ...decode filename...
+ *       write_chunk("f32_", samples, &out);
+ *   });
+ *   std::span< float const > samples = blob->read_chunk< float >("f32_");
+ */
+
+#include "MappedFile.hpp"
+
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+//Return a mapped blob for 'source' as converted by 'converter' (at 'version'),
+// calling 'convert' to write the blob (and storing it in the cache) if there isn't one yet.
+// If the cache directory can't be written, the blob is still converted, just not kept.
+std::unique_ptr< MappedFile > cached_asset(std::string const &source, std::string const &converter, uint32_t version,
+	std::function< void(std::ostream &) > const &convert);
+
+//..the same, but for blobs made from something other than a single file, under a key you compute
+// (e.g., with hash_bytes; 'source' is just for messages):
+std::unique_ptr< MappedFile > cached_blob(uint64_t key, std::string const &source,
+	std::function< void(std::ostream &) > const &convert);
+
+//..or just look for one (returns nullptr if there isn't one, or the cache is off):
+std::unique_ptr< MappedFile > find_cached_blob(uint64_t key);
+
+//delete a blob (e.g., one that turned out to be unusable) so the next cached_blob() call makes it again:
+void forget_cached_blob(uint64_t key);
+
+//Where blobs are kept (default: data_path("asset-cache")); set to "" to turn the cache off:
+extern std::string asset_cache_dir;
+
+//64-bit hash of some bytes (fast; not cryptographic):
+uint64_t hash_bytes(void const *data, size_t size, uint64_t seed = 0);
@@ -0,0 +1,140 @@
+//bvh-bench: how much does Scene's drawable BVH save over testing every drawable?
+//
+// Builds scenes with N drawables (small boxes scattered through a city-block-sized volume,
+// a tenth of them moving every frame), then reports per-frame times for:
+//  - 'linear': world box + frustum test for every drawable (the old culling path)
+//  - 'bvh': BVH frustum query
+//  - 'refit': Scene::update_world_from_local with the movers (transform update + BVH refit)
+//  - 'build': building the BVH from scratch
+// and microseconds per ray for picking with a linear scan vs. Scene::pick.
+// Checks that both culling paths and both picking paths agree.
+
+#include "Scene.hpp"
+#include "Frustum.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+
+int main(int argc, char **argv) {
+	if (argc > 2) {
+		std::cerr << "Usage:\n\t./bvh-bench [frames=100]" << std::endl;
+		return 1;
+	}
+	uint32_t frames = (argc > 1 ? uint32_t(std::stoul(argv[1])) : 100);
+
+	std::cout << "bvh-bench: " << frames << " frames per row; times in microseconds." << std::endl;
+	std::cout << std::setw(10) << "drawables" << std::setw(9) << "visible"
+	          << std::setw(10) << "linear" << std::setw(10) << "bvh" << std::setw(10) << "refit" << std::setw(10) << "build"
+	          << std::setw(13) << "pick linear" << std::setw(10) << "pick bvh" << std::endl;
+
+	auto seconds_since = [](std::chrono::high_resolution_clock::time_point const &before) {
+		return std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+	};
+
+	for (uint32_t count : {10000, 30000, 100000}) {
+		Scene scene;
+		std::mt19937 mt(0x15466);
+		auto rand01 = [&]() { return mt() / float(mt.max()); };
+		for (uint32_t i = 0; i < count; ++i) {
+			uint32_t t = scene.transforms.add("obj" + std::to_string(i));
+			scene.transforms.positions[t] = glm::vec3(rand01() * 1000.0f - 500.0f, rand01() * 1000.0f - 500.0f, rand01() * 50.0f);
+			scene.transforms.rotations[t] = glm::normalize(glm::quat(rand01(), rand01(), rand01(), rand01()));
+			scene.drawables.emplace_back(t);
+			scene.drawables.back().min = glm::vec3(-1.0f);
+			scene.drawables.back().max = glm::vec3(1.0f, 1.0f, 1.0f + 4.0f * rand01());
+		}
+
+		glm::mat4 clip_from_world =
+			glm::infinitePerspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f)
+			* glm::lookAt(glm::vec3(-300.0f, -300.0f, 20.0f), glm::vec3(-200.0f, -300.0f, 15.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+		Frustum frustum(clip_from_world);
+
+		auto before = std::chrono::high_resolution_clock::now();
+		scene.update_world_from_local(); //(builds the BVH)
+		double build_seconds = seconds_since(before);
+
+		double linear_seconds = 0.0, bvh_seconds = 0.0, refit_seconds = 0.0;
+		std::vector< uint32_t > linear_visible, bvh_visible;
+		for (uint32_t frame = 0; frame < frames; ++frame) {
+			for (uint32_t i = 0; i < count; i += 10) {
+				scene.transforms.positions[i].z = 25.0f + 25.0f * std::sin(0.1f * float(frame + i));
+			}
+
+			before = std::chrono::high_resolution_clock::now();
+			scene.update_world_from_local();
+			refit_seconds += seconds_since(before);
+
+			before = std::chrono::high_resolution_clock::now();
+			linear_visible.clear();
+			for (uint32_t i = 0; i < count; ++i) {
+				Scene::Drawable const &drawable = scene.drawables[i];
+				glm::vec3 center, radius;
+				Frustum::world_box(scene.transforms.world_from_local[drawable.transform], drawable.min, drawable.max, &center, &radius);
+				if (frustum.overlaps(center, radius)) linear_visible.emplace_back(i);
+			}
+			linear_seconds += seconds_since(before);
+
+			before = std::chrono::high_resolution_clock::now();
+			bvh_visible.clear();
+			scene.drawable_bvh.bvh.query(frustum, &bvh_visible);
+			bvh_seconds += seconds_since(before);
+
+			if (bvh_visible.size() != linear_visible.size()) {
+				std::cerr << "BVH found " << bvh_visible.size() << " visible drawables, linear found " << linear_visible.size() << "!" << std::endl;
+				return 1;
+			}
+		}
+
+		before = std::chrono::high_resolution_clock::now();
+		scene.drawables_changed();
+		scene.update_world_from_local();
+		build_seconds = std::min(build_seconds, seconds_since(before));
+
+		//picking: rays from above, straight down at random spots:
+		uint32_t const rays = 1000;
+		double pick_linear_seconds = 0.0, pick_bvh_seconds = 0.0;
+		for (uint32_t r = 0; r < rays; ++r) {
+			glm::vec3 origin = glm::vec3(rand01() * 1000.0f - 500.0f, rand01() * 1000.0f - 500.0f, 100.0f);
+			glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+
+			before = std::chrono::high_resolution_clock::now();
+			float best_t = std::numeric_limits< float >::infinity();
+			for (uint32_t i = 0; i < count; ++i) {
+				Scene::Drawable const &drawable = scene.drawables[i];
+				glm::vec3 center, radius;
+				Frustum::world_box(scene.transforms.world_from_local[drawable.transform], drawable.min, drawable.max, &center, &radius);
+				if (std::abs(origin.x - center.x) <= radius.x && std::abs(origin.y - center.y) <= radius.y) {
+					best_t = std::min(best_t, origin.z - (center.z + radius.z));
+				}
+			}
+			pick_linear_seconds += seconds_since(before);
+
+			before = std::chrono::high_resolution_clock::now();
+			float t = std::numeric_limits< float >::infinity();
+			scene.pick(origin, direction, &t);
+			pick_bvh_seconds += seconds_since(before);
+
+			if (std::abs(t - best_t) > 1e-3f && !(std::isinf(t) && std::isinf(best_t))) {
+				std::cerr << "BVH pick hit at " << t << ", linear pick hit at " << best_t << "!" << std::endl;
+				return 1;
+			}
+		}
+
+		std::cout << std::setw(10) << count << std::setw(9) << bvh_visible.size()
+		          << std::setw(10) << std::setprecision(4) << 1e6 * linear_seconds / frames
+		          << std::setw(10) << std::setprecision(4) << 1e6 * bvh_seconds / frames
+		          << std::setw(10) << std::setprecision(4) << 1e6 * refit_seconds / frames
+		          << std::setw(10) << std::setprecision(4) << 1e6 * build_seconds
+		          << std::setw(13) << std::setprecision(4) << 1e6 * pick_linear_seconds / rays
+		          << std::setw(10) << std::setprecision(4) << 1e6 * pick_bvh_seconds / rays << std::endl;
+	}
+
+	return 0;
+}
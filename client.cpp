@@ -3,8 +3,10 @@
 #include "Connection.hpp"
 #include "Mode.hpp"
 #include "Load.hpp"
+#include "Residency.hpp"
 #include "Sound.hpp"
 #include "GL.hpp"
+#include "gl_indirect.hpp"
 #include "load_save_png.hpp"
 
 //Includes for libSDL:
@@ -91,6 +93,8 @@ int main(int argc, char **argv) {
 
 	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
 	init_GL();
+	//(optional; Scene::draw uses multi-draw-indirect when available)
+	init_GL_indirect();
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
 	if (!SDL_GL_SetSwapInterval(-1)) {
@@ -181,6 +185,9 @@ int main(int argc, char **argv) {
 
 			Mode::current->update(elapsed);
 			if (!Mode::current) break;
+
+			//finish any background asset loads and keep resident assets within budget:
+			Residency::update();
 		}
 
 		{ //(3) call the current mode's "draw" function to produce output:
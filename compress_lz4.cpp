@@ -0,0 +1,148 @@
+#include "compress_lz4.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	constexpr size_t MaxOffset = 65535; //matches are at most this far back
+	constexpr size_t MinMatch = 4;
+	constexpr size_t LastLiterals = 5; //block must end with at least this many literals
+	constexpr size_t MatchSafeDistance = 12; //last match must start at least this far from the end
+	constexpr uint32_t HashBits = 12;
+
+	uint32_t read32(uint8_t const *at) {
+		uint32_t ret;
+		std::memcpy(&ret, at, 4);
+		return ret;
+	}
+	uint32_t hash4(uint32_t val) {
+		return (val * 2654435761u) >> (32 - HashBits);
+	}
+}
+
+void compress_lz4(std::span< uint8_t const > data, std::span< uint8_t const > dictionary_, std::vector< uint8_t > *out_) {
+	auto &out = *out_;
+	std::span< uint8_t const > dictionary = dictionary_.last(std::min(dictionary_.size(), MaxOffset));
+
+	//work on dictionary followed by data, so matches can reach back into the dictionary:
+	std::vector< uint8_t > work;
+	work.reserve(dictionary.size() + data.size());
+	work.insert(work.end(), dictionary.begin(), dictionary.end());
+	work.insert(work.end(), data.begin(), data.end());
+	size_t const begin = dictionary.size();
+	size_t const end = work.size();
+
+	//most recent position of each (hashed) 4-byte sequence:
+	constexpr uint32_t None = uint32_t(-1);
+	std::vector< uint32_t > table(size_t(1) << HashBits, None);
+	for (size_t p = 0; p + MinMatch <= begin; ++p) {
+		table[hash4(read32(&work[p]))] = uint32_t(p);
+	}
+
+	auto send_length = [&](size_t length) {
+		//(caller has already put the first 15 in the token)
+		length -= 15;
+		while (length >= 255) {
+			out.emplace_back(uint8_t(255));
+			length -= 255;
+		}
+		out.emplace_back(uint8_t(length));
+	};
+
+	//literals [anchor, at) followed by a match of 'length' bytes from 'offset' back (length 0 for the final literals):
+	auto send_sequence = [&](size_t anchor, size_t at, size_t offset, size_t length) {
+		size_t literals = at - anchor;
+		uint8_t token = uint8_t(std::min< size_t >(literals, 15) << 4);
+		if (length) token |= uint8_t(std::min< size_t >(length - MinMatch, 15));
+		out.emplace_back(token);
+		if (literals >= 15) send_length(literals);
+		out.insert(out.end(), work.begin() + anchor, work.begin() + at);
+		if (length) {
+			out.emplace_back(uint8_t(offset));
+			out.emplace_back(uint8_t(offset >> 8));
+			if (length - MinMatch >= 15) send_length(length - MinMatch);
+		}
+	};
+
+	size_t anchor = begin;
+	if (end - begin > MatchSafeDistance) {
+		size_t const match_limit = end - MatchSafeDistance;
+		size_t const match_end = end - LastLiterals;
+		for (size_t at = begin; at < match_limit; /* later */) {
+			uint32_t val = read32(&work[at]);
+			uint32_t &slot = table[hash4(val)];
+			size_t candidate = slot;
+			slot = uint32_t(at);
+
+			if (candidate == None || at - candidate > MaxOffset || read32(&work[candidate]) != val) {
+				++at;
+				continue;
+			}
+
+			size_t length = MinMatch;
+			while (at + length < match_end && work[candidate + length] == work[at + length]) ++length;
+
+			send_sequence(anchor, at, at - candidate, length);
+			at += length;
+			anchor = at;
+			//(also remember a position inside the match, which helps with repeated records)
+			if (at - 2 >= begin) table[hash4(read32(&work[at - 2]))] = uint32_t(at - 2);
+		}
+	}
+	send_sequence(anchor, end, 0, 0);
+}
+
+void decompress_lz4(std::span< uint8_t const > block, std::span< uint8_t const > dictionary_, size_t size, std::vector< uint8_t > *out) {
+	std::span< uint8_t const > dictionary = dictionary_.last(std::min(dictionary_.size(), MaxOffset));
+
+	//output goes after the dictionary, so matches can reach back into it:
+	std::vector< uint8_t > work;
+	work.reserve(dictionary.size() + size);
+	work.insert(work.end(), dictionary.begin(), dictionary.end());
+	size_t const limit = dictionary.size() + size;
+
+	size_t at = 0;
+	auto next_byte = [&]() -> uint8_t {
+		if (at >= block.size()) throw std::runtime_error("LZ4 block ends in the middle of a sequence.");
+		return block[at++];
+	};
+	auto read_length = [&](size_t length) {
+		if (length == 15) {
+			uint8_t b;
+			do {
+				b = next_byte();
+				length += b;
+			} while (b == 255);
+		}
+		return length;
+	};
+
+	while (true) {
+		uint8_t token = next_byte();
+
+		size_t literals = read_length(token >> 4);
+		if (literals > block.size() - at || literals > limit - work.size()) {
+			throw std::runtime_error("LZ4 block has too many literals.");
+		}
+		work.insert(work.end(), block.begin() + at, block.begin() + at + literals);
+		at += literals;
+
+		if (at == block.size()) break; //(last sequence is only literals)
+
+		size_t offset = next_byte();
+		offset |= size_t(next_byte()) << 8;
+		if (offset == 0 || offset > work.size()) throw std::runtime_error("LZ4 block has match offset out of range.");
+
+		size_t length = read_length(token & 0xf) + MinMatch;
+		if (length > limit - work.size()) throw std::runtime_error("LZ4 block decompresses to more than expected.");
+		//(byte-by-byte, since the match may overlap what it is producing)
+		size_t from = work.size() - offset;
+		for (size_t i = 0; i < length; ++i) {
+			work.emplace_back(work[from + i]);
+		}
+	}
+
+	if (work.size() != limit) throw std::runtime_error("LZ4 block decompresses to less than expected.");
+	out->assign(work.begin() + dictionary.size(), work.end());
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Small compressor / decompressor for the LZ4 block format:
+ *  https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+ *
+ * Matches may reach back into a shared 'dictionary' (the last 64k of it),
+ *  so short messages with a known layout still compress well. The same
+ *  dictionary must be passed to decompress.
+ *
+ * (Output is compatible with LZ4_decompress_safe_usingDict, so this can be
+ *  swapped for the real liblz4 if nest-libs ever picks it up.)
+ */
+
+//append the compressed form of 'data' to 'out':
+void compress_lz4(std::span< uint8_t const > data, std::span< uint8_t const > dictionary, std::vector< uint8_t > *out);
+
+//decompress 'block' into 'out' (replacing its contents):
+//NOTE: throws on malformed block, or if it doesn't decompress to exactly 'size' bytes
+void decompress_lz4(std::span< uint8_t const > block, std::span< uint8_t const > dictionary, size_t size, std::vector< uint8_t > *out);
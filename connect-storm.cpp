@@ -0,0 +1,134 @@
+//connect-storm: measures how quickly Server accepts a burst of incoming connections.
+//
+// Opens a Server on <port>, then has a helper thread open <connections> TCP connections
+// to it as fast as it can, and times how long Server::poll() takes to accept them all.
+// This is run twice: once accepting one connection per poll() (the old behavior) and
+// once with the default batched accept.
+//
+// (Server logs every accepted connection to stderr; run with 2>/dev/null for cleaner output.)
+// (Both ends of every connection live in this process and Server uses select(), so keep
+//  <connections> comfortably below FD_SETSIZE / 2 -- i.e., about 500 on linux.)
+
+#include "Connection.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#define closesocket close
+#endif
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+//fire off 'count' non-blocking connects to 127.0.0.1:port, store sockets in 'out':
+// (doesn't wait for handshakes to finish, so the server sees them arrive all at once)
+static void connect_storm(uint16_t port, uint32_t count, std::vector< Socket > *out, std::atomic< uint32_t > *failed) {
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	out->reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		Socket s = socket(AF_INET, SOCK_STREAM, 0);
+		if (s == InvalidSocket) {
+			*failed += 1;
+			continue;
+		}
+		#ifdef _WIN32
+		unsigned long one = 1;
+		ioctlsocket(s, FIONBIO, &one);
+		bool started = (connect(s, reinterpret_cast< struct sockaddr * >(&addr), sizeof(addr)) == 0 || WSAGetLastError() == WSAEWOULDBLOCK);
+		#else
+		fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+		bool started = (connect(s, reinterpret_cast< struct sockaddr * >(&addr), sizeof(addr)) == 0 || errno == EINPROGRESS);
+		#endif
+		if (!started) {
+			closesocket(s);
+			*failed += 1;
+			continue;
+		}
+		out->emplace_back(s);
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2 || argc > 4) {
+		std::cerr << "Usage:\n\t./connect-storm <port> [connections=400] [backlog=" << Server::DefaultBacklog << "]" << std::endl;
+		return 1;
+	}
+	uint16_t port = uint16_t(std::stoul(argv[1]));
+	uint32_t count = (argc > 2 ? uint32_t(std::stoul(argv[2])) : 400);
+	int backlog = (argc > 3 ? std::stoi(argv[3]) : Server::DefaultBacklog);
+
+	Server server(argv[1], backlog);
+	uint32_t const batched_accepts = server.max_accepts_per_poll;
+
+	auto run = [&](char const *label, uint32_t max_accepts_per_poll) {
+		server.max_accepts_per_poll = max_accepts_per_poll;
+
+		std::vector< Socket > sockets;
+		std::atomic< uint32_t > failed(0);
+
+		uint32_t opened = 0;
+		uint32_t polls = 0;
+		uint32_t busiest_poll = 0;
+
+		auto before = std::chrono::high_resolution_clock::now();
+		std::thread storm(connect_storm, port, count, &sockets, &failed);
+		auto last_progress = before;
+		while (opened + failed < count) {
+			if (std::chrono::high_resolution_clock::now() - last_progress > std::chrono::seconds(10)) {
+				//(a full accept queue drops SYNs, which are retried after 1s, 3s, 7s, ...)
+				std::cerr << "(giving up: no new connections for ten seconds)" << std::endl;
+				break;
+			}
+			uint32_t opened_this_poll = 0;
+			server.poll([&](Connection *, Connection::Event evt) {
+				if (evt == Connection::OnOpen) opened_this_poll += 1;
+			}, 0.01);
+			if (opened_this_poll) {
+				polls += 1;
+				busiest_poll = std::max(busiest_poll, opened_this_poll);
+				opened += opened_this_poll;
+				last_progress = std::chrono::high_resolution_clock::now();
+			}
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		storm.join();
+
+		double seconds = std::chrono::duration< double >(after - before).count();
+		std::cout << label << ": accepted " << opened << " of " << count << " connections (" << failed << " failed to connect) in "
+		          << seconds * 1000.0 << " ms -- " << (opened / seconds) << " accepts/s, "
+		          << (polls ? double(opened) / polls : 0.0) << " accepts per wakeup (max " << busiest_poll << ")." << std::endl;
+
+		//tear down both ends before the next round:
+		// (and keep polling briefly so stragglers from retransmitted SYNs don't leak into the next round)
+		for (Socket s : sockets) closesocket(s);
+		for (uint32_t settle = 0; settle < 10; ++settle) {
+			for (auto &c : server.connections) c.close();
+			server.poll(nullptr, 0.01);
+		}
+	};
+
+	std::cout << "connect-storm: " << count << " connections to port " << port << ", listen backlog " << backlog << "." << std::endl;
+	run("one accept per poll", 1);
+	run("batched accept", batched_accepts);
+
+	return 0;
+}
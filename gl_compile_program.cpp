@@ -1,50 +1,214 @@
 #include "gl_compile_program.hpp"
 
+#include "asset_cache.hpp"
+#include "read_write_chunk.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <chrono>
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <cstring>
 
-static GLuint gl_compile_shader(GLenum type, std::string const &source) {
-	GLuint shader = glCreateShader(type);
-	GLchar const *str = source.c_str();
-	GLint str_length = GLint(source.size());
-	glShaderSource(shader, 1, &str, &str_length);
-	glCompileShader(shader);
-	GLint compile_status = GL_FALSE;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
-	if (compile_status != GL_TRUE) {
-		std::cerr << "Failed to compile shader." << std::endl;
-		GLint info_log_length = 0;
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::vector< GLchar > info_log(info_log_length, 0);
-		GLsizei length = 0;
-		glGetShaderInfoLog(shader, GLint(info_log.size()), &length, &info_log[0]);
-		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
-		glDeleteShader(shader);
-		throw std::runtime_error("Failed to compile shader.");
-	}
-	return shader;
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH          0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS     0x87FE
+
+//program binaries (core since OpenGL 4.1) and parallel shader compiles (an extension) are not part of
+// the 3.3 core profile that GL.hpp covers, so are looked up at runtime:
+struct GLProgramFunctions {
+	void (APIENTRY *GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) = nullptr;
+	void (APIENTRY *ProgramBinary)(GLuint program, GLenum binaryFormat, void const *binary, GLsizei length) = nullptr;
+	void (APIENTRY *ProgramParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+	uint64_t driver = 0; //hash of the vendor/renderer/version strings (binaries are only good for the driver that made them)
+};
+
+//(looked up the first time a program is submitted, which is after init_GL())
+static GLProgramFunctions const &gl_program_functions() {
+	static GLProgramFunctions const functions = []() {
+		GLProgramFunctions found;
+
+		bool program_binary = false;
+		char const *max_threads_name = nullptr;
+		GLint extensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+		for (GLint i = 0; i < extensions; ++i) {
+			char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+			if (!name) continue;
+			if (std::strcmp(name, "GL_ARB_get_program_binary") == 0) program_binary = true;
+			if (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0) max_threads_name = "glMaxShaderCompilerThreadsKHR";
+			if (std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0 && !max_threads_name) max_threads_name = "glMaxShaderCompilerThreadsARB";
+		}
+
+		//let the driver use as many compiler threads as it likes:
+		// (this is the default, but some drivers only start their threads once asked)
+		if (max_threads_name) {
+			void (APIENTRY *MaxShaderCompilerThreads)(GLuint count) = nullptr;
+			MaxShaderCompilerThreads = (decltype(MaxShaderCompilerThreads))SDL_GL_GetProcAddress(max_threads_name);
+			if (MaxShaderCompilerThreads) MaxShaderCompilerThreads(0xffffffff);
+		}
+
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		if (major > 4 || (major == 4 && minor >= 1)) program_binary = true;
+		//(some drivers support the functions but no formats, which means no binaries)
+		GLint formats = 0;
+		if (program_binary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		if (formats > 0) {
+			found.GetProgramBinary = (decltype(found.GetProgramBinary))SDL_GL_GetProcAddress("glGetProgramBinary");
+			found.ProgramBinary = (decltype(found.ProgramBinary))SDL_GL_GetProcAddress("glProgramBinary");
+			found.ProgramParameteri = (decltype(found.ProgramParameteri))SDL_GL_GetProcAddress("glProgramParameteri");
+		}
+		if (!found.GetProgramBinary || !found.ProgramBinary || !found.ProgramParameteri) {
+			found.GetProgramBinary = nullptr;
+			found.ProgramBinary = nullptr;
+			found.ProgramParameteri = nullptr;
+		}
+
+		for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+			char const *str = reinterpret_cast< char const * >(glGetString(name));
+			if (str) found.driver = hash_bytes(str, std::strlen(str), found.driver);
+		}
+		return found;
+	}();
+	return functions;
 }
 
-GLuint gl_compile_program(
+//stored in the asset cache ahead of a program binary:
+struct BinaryInfo {
+	GLenum format;
+	float compile_ms; //how long compiling from source took (on the main thread), for comparison
+};
+static_assert(sizeof(BinaryInfo) == 8, "BinaryInfo is packed.");
+
+static float ms_since(std::chrono::high_resolution_clock::time_point before) {
+	return std::chrono::duration< float, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+}
+
+//start compiling + linking from source (doesn't wait for -- or check -- the result):
+static void submit_from_source(GLProgramBuild &build) {
+	auto submit_shader = [](GLenum type, std::string const &source) {
+		GLuint shader = glCreateShader(type);
+		GLchar const *str = source.c_str();
+		GLint str_length = GLint(source.size());
+		glShaderSource(shader, 1, &str, &str_length);
+		glCompileShader(shader);
+		return shader;
+	};
+	build.vertex_shader = submit_shader(GL_VERTEX_SHADER, build.vertex_shader_source);
+	build.fragment_shader = submit_shader(GL_FRAGMENT_SHADER, build.fragment_shader_source);
+
+	build.program = glCreateProgram();
+	glAttachShader(build.program, build.vertex_shader);
+	glAttachShader(build.program, build.fragment_shader);
+
+	//ask the driver to keep the binary around for glGetProgramBinary:
+	if (build.key) gl_program_functions().ProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	//(the link also happens in the background, so no need to wait for the compiles first)
+	glLinkProgram(build.program);
+	build.from_binary = false;
+}
+
+GLProgramBuild gl_submit_program(
 	std::string const &vertex_shader_source,
-	std::string const &fragment_shader_source
+	std::string const &fragment_shader_source,
+	std::source_location where
 	) {
+	auto before = std::chrono::high_resolution_clock::now();
+
+	GLProgramBuild build;
+	build.vertex_shader_source = vertex_shader_source;
+	build.fragment_shader_source = fragment_shader_source;
+	build.name = where.file_name();
+	build.name = build.name.substr(build.name.find_last_of("/\\") + 1) + ":" + std::to_string(where.line());
+
+	GLProgramFunctions const &functions = gl_program_functions();
+	if (functions.ProgramBinary && !asset_cache_dir.empty()) {
+		build.key = hash_bytes(vertex_shader_source.data(), vertex_shader_source.size());
+		build.key = hash_bytes(fragment_shader_source.data(), fragment_shader_source.size(), build.key);
+		build.key = hash_bytes(&functions.driver, sizeof(functions.driver), build.key);
+	}
+
+	//if there's a cached binary, start loading it:
+	// (if not, gl_await_program caches one once the program is linked)
+	std::unique_ptr< MappedFile > blob;
+	if (build.key) blob = find_cached_blob(build.key);
+	if (blob) {
+		std::span< BinaryInfo const > info;
+		std::span< uint8_t const > binary;
+		try {
+			info = blob->read_chunk< BinaryInfo >("pbi0");
+			binary = blob->read_chunk< uint8_t >("pbin");
+		} catch (std::exception &e) {
+			std::cerr << "WARNING: ignoring malformed cached binary for program at " << build.name << ": " << e.what() << std::endl;
+		}
+		if (info.size() == 1 && !binary.empty()) {
+			build.program = glCreateProgram();
+			functions.ProgramBinary(build.program, info[0].format, binary.data(), GLsizei(binary.size()));
+			build.from_binary = true;
+			build.binary_compile_ms = info[0].compile_ms;
+		} else {
+			blob.reset();
+			forget_cached_blob(build.key);
+		}
+	}
+
+	if (!build.from_binary) submit_from_source(build);
+
+	build.main_thread_ms += ms_since(before);
+	return build;
+}
+
+GLuint gl_await_program(GLProgramBuild &&build) {
+	auto before = std::chrono::high_resolution_clock::now();
 
-	GLuint vertex_shader = gl_compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	GLuint fragment_shader = gl_compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+	if (build.from_binary) {
+		GLint link_status = GL_FALSE;
+		glGetProgramiv(build.program, GL_LINK_STATUS, &link_status);
+		if (link_status == GL_TRUE) {
+			build.main_thread_ms += ms_since(before);
+			std::cout << "Program at " << build.name << " loaded from cached binary in " << build.main_thread_ms << "ms"
+			          << " (saves " << build.binary_compile_ms - build.main_thread_ms << "ms)." << std::endl;
+			return build.program;
+		}
+		glDeleteProgram(build.program);
+		glGetError(); //(clear GL_INVALID_ENUM if the driver doesn't take this format any more)
 
-	GLuint program = glCreateProgram();
-	glAttachShader(program, vertex_shader);
-	glAttachShader(program, fragment_shader);
+		//binary is unusable (e.g., a driver update that kept the same version string); make a new one:
+		forget_cached_blob(build.key);
+		submit_from_source(build);
+	}
+
+	auto check_shader = [&build](GLuint shader) {
+		GLint compile_status = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
+		if (compile_status != GL_TRUE) {
+			std::cerr << "Failed to compile shader." << std::endl;
+			GLint info_log_length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
+			std::vector< GLchar > info_log(info_log_length, 0);
+			GLsizei length = 0;
+			glGetShaderInfoLog(shader, GLint(info_log.size()), &length, &info_log[0]);
+			std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
+			glDeleteShader(build.vertex_shader);
+			glDeleteShader(build.fragment_shader);
+			glDeleteProgram(build.program);
+			throw std::runtime_error("Failed to compile shader.");
+		}
+	};
+	check_shader(build.vertex_shader);
+	check_shader(build.fragment_shader);
 
 	//shaders are reference counted so this makes sure they are freed after program is deleted:
-	glDeleteShader(vertex_shader);
-	glDeleteShader(fragment_shader);
+	glDeleteShader(build.vertex_shader);
+	glDeleteShader(build.fragment_shader);
 
-	//link the shader program and throw errors if linking fails:
-	glLinkProgram(program);
+	//throw errors if linking failed:
+	GLuint program = build.program;
 	GLint link_status = GL_FALSE;
 	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
 	if (link_status != GL_TRUE) {
@@ -57,6 +221,34 @@ GLuint gl_compile_program(
 		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
 		throw std::runtime_error("failed to link program");
 	}
+	build.main_thread_ms += ms_since(before);
+
+	if (build.key) {
+		std::vector< BinaryInfo > info(1);
+		info[0].compile_ms = build.main_thread_ms;
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		std::vector< uint8_t > binary(length);
+		GLsizei got = 0;
+		gl_program_functions().GetProgramBinary(program, length, &got, &info[0].format, binary.data());
+		binary.resize(got);
+
+		if (!binary.empty()) {
+			cached_blob(build.key, "program at " + build.name, [&](std::ostream &out) {
+				write_chunk("pbi0", info, &out);
+				write_chunk("pbin", binary, &out);
+			});
+		}
+		std::cout << "Program at " << build.name << " compiled in " << build.main_thread_ms << "ms (binary cached for next time)." << std::endl;
+	}
 
 	return program;
 }
+
+GLuint gl_compile_program(
+	std::string const &vertex_shader_source,
+	std::string const &fragment_shader_source,
+	std::source_location where
+	) {
+	return gl_await_program(gl_submit_program(vertex_shader_source, fragment_shader_source, where));
+}
@@ -2,10 +2,43 @@
 
 #include "GL.hpp"
 
+#include <source_location>
 #include <string>
+#include <cstdint>
 
 //compiles+links an OpenGL shader program from source.
 // throws on compilation error.
+//
+// Where the driver supports program binaries (OpenGL 4.1 / ARB_get_program_binary),
+//  linked programs are kept in the asset cache (see asset_cache.hpp), keyed by the
+//  sources and the driver's vendor/renderer/version strings, and later launches load
+//  the binary instead of compiling. Binaries the driver rejects are quietly rebuilt.
+// ('where' names the program in the timing messages printed at startup.)
 GLuint gl_compile_program(
 	std::string const &vertex_shader_source,
-	std::string const &fragment_shader_source);
+	std::string const &fragment_shader_source,
+	std::source_location where = std::source_location::current());
+
+//gl_compile_program() in two halves, so that many programs can be compiling at once:
+// gl_submit_program() starts compiling (or loading a cached binary) and returns without checking the result;
+// gl_await_program() waits for it to finish and returns the program (throwing on errors).
+// Submit every program before awaiting any of them; on drivers with KHR_parallel_shader_compile
+//  the compiles then run side-by-side on the driver's threads.
+// (Load< T > can do this for you -- see LoadSubmitFirst in Load.hpp.)
+struct GLProgramBuild {
+	GLuint program = 0;
+	GLuint vertex_shader = 0, fragment_shader = 0; //(zero if the program came from a cached binary)
+	std::string vertex_shader_source, fragment_shader_source; //(kept in case a cached binary is rejected)
+	std::string name; //for messages
+	uint64_t key = 0; //in the asset cache (if caching)
+	bool from_binary = false;
+	float binary_compile_ms = 0.0f; //(if from_binary) how long compiling took when the binary was made
+	float main_thread_ms = 0.0f; //time spent on the main thread so far
+};
+
+GLProgramBuild gl_submit_program(
+	std::string const &vertex_shader_source,
+	std::string const &fragment_shader_source,
+	std::source_location where = std::source_location::current());
+
+GLuint gl_await_program(GLProgramBuild &&build);
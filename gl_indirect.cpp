@@ -0,0 +1,38 @@
+#include "gl_indirect.hpp"
+
+#include <SDL3/SDL.h>
+#include <cstring>
+
+GLIndirect gl_indirect;
+
+bool init_GL_indirect() {
+	gl_indirect = GLIndirect();
+
+	//need glMultiDraw*Indirect *and* non-zero base_instance, so GL 4.3 or both extensions:
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	bool supported = (major > 4 || (major == 4 && minor >= 3));
+	if (!supported) {
+		bool multi_draw_indirect = false;
+		bool base_instance = false;
+		GLint extensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+		for (GLint i = 0; i < extensions; ++i) {
+			char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+			if (!name) continue;
+			if (std::strcmp(name, "GL_ARB_multi_draw_indirect") == 0) multi_draw_indirect = true;
+			if (std::strcmp(name, "GL_ARB_base_instance") == 0) base_instance = true;
+		}
+		supported = multi_draw_indirect && base_instance;
+	}
+	if (!supported) return false;
+
+	GLIndirect found;
+	found.MultiDrawArraysIndirect = (decltype(found.MultiDrawArraysIndirect))SDL_GL_GetProcAddress("glMultiDrawArraysIndirect");
+	found.MultiDrawElementsIndirect = (decltype(found.MultiDrawElementsIndirect))SDL_GL_GetProcAddress("glMultiDrawElementsIndirect");
+	if (!found.MultiDrawArraysIndirect || !found.MultiDrawElementsIndirect) return false;
+
+	gl_indirect = found;
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+ * Multi-draw-indirect (glMultiDrawArraysIndirect, core since OpenGL 4.3) is not
+ *  part of the 3.3 core profile that GL.hpp covers, so it is looked up at runtime.
+ *
+ * Call init_GL_indirect() after init_GL(). If the context doesn't support it
+ *  (e.g., on MacOS, which stops at 4.1), the gl_indirect function pointers
+ *  stay null and callers should draw some other way.
+ *
+ */
+
+#include "GL.hpp"
+
+//(GL.hpp stops at 3.3, but a platform header may already have this)
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER           0x8F3F
+#endif
+
+//one entry in a GL_DRAW_INDIRECT_BUFFER (layout fixed by the spec):
+struct DrawArraysIndirectCommand {
+	GLuint count; //vertices to draw
+	GLuint instance_count;
+	GLuint first; //first vertex
+	GLuint base_instance; //first instance -- offsets per-instance (divisor 1) attributes
+};
+static_assert(sizeof(DrawArraysIndirectCommand) == 4*4, "DrawArraysIndirectCommand is packed.");
+
+//..and for indexed drawing:
+struct DrawElementsIndirectCommand {
+	GLuint count; //indices to draw
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex; //added to each index
+	GLuint base_instance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 5*4, "DrawElementsIndirectCommand is packed.");
+
+struct GLIndirect {
+	void (APIENTRY *MultiDrawArraysIndirect)(GLenum mode, void const *indirect, GLsizei drawcount, GLsizei stride) = nullptr;
+	void (APIENTRY *MultiDrawElementsIndirect)(GLenum mode, GLenum type, void const *indirect, GLsizei drawcount, GLsizei stride) = nullptr;
+};
+extern GLIndirect gl_indirect;
+
+//returns true (and sets up gl_indirect) if multi-draw-indirect is available:
+bool init_GL_indirect();
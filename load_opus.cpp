@@ -1,4 +1,6 @@
 #include "load_opus.hpp"
+#include "asset_cache.hpp"
+#include "read_write_chunk.hpp"
 
 #include <opusfile.h>
 
@@ -8,17 +10,21 @@
 #include <stdexcept>
 #include <iostream>
 
-void load_opus(std::string const &filename, std::vector< float > *data_) {
+//decode without the cache:
+static void decode_opus(std::string const &filename, std::vector< float > *data_) {
 	assert(data_);
 	auto &data = *data_;
 	data.clear();
 
 	std::cout << "loading '" << filename << "'..."; std::cout.flush();
 
+	//(read through MappedFile so the file can come from the asset pack)
+	MappedFile file(filename);
+
 	//will hold opusfile * int a std::unique_ptr so that it will automatically be deleted:
 	int err = 0;
 	std::unique_ptr< OggOpusFile, decltype(&op_free) > op(
-		op_open_file(filename.c_str(), &err), //pointer to hold
+		op_open_memory(reinterpret_cast< unsigned char const * >(file.data), file.size, &err), //pointer to hold
 		op_free //deletion function
 	);
 	if (err != 0) {
@@ -52,3 +58,18 @@ void load_opus(std::string const &filename, std::vector< float > *data_) {
 
 	std::cout << " done." << std::endl;
 }
+
+void load_opus(std::string const &filename, std::vector< float > *data_) {
+	assert(data_);
+	auto &data = *data_;
+
+	//decoding is slow, so decoded samples are kept in the asset cache:
+	// (bump the version if decode_opus's output changes)
+	std::unique_ptr< MappedFile > blob = cached_asset(filename, "opus-48k-f32-mono", 1, [&](std::ostream &out) {
+		std::vector< float > decoded;
+		decode_opus(filename, &decoded);
+		write_chunk("pcmf", decoded, &out);
+	});
+	std::span< float const > samples = blob->read_chunk< float >("pcmf");
+	data.assign(samples.begin(), samples.end());
+}
@@ -1,9 +1,12 @@
 #include "load_save_png.hpp"
+#include "asset_cache.hpp"
+#include "read_write_chunk.hpp"
 
 #include <png.h>
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cassert>
 #include <vector>
 
@@ -16,14 +19,30 @@ void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8
 
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
 	assert(size);
+	assert(data);
 
-	std::ifstream file(filename.c_str(), std::ios::binary);
-	if (!file) {
-		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
-	}
-	if (!load_png(file, &size->x, &size->y, data, origin)) {
-		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
+	//expanded pixels are kept in the asset cache:
+	// (bump the version if the expanded format changes)
+	std::string converter = (origin == LowerLeftOrigin ? "png-rgba8-lower-left" : "png-rgba8-upper-left");
+	std::unique_ptr< MappedFile > blob = cached_asset(filename, converter, 1, [&](std::ostream &out) {
+		//(read through MappedFile so the file can come from the asset pack)
+		MappedFile mapped(filename);
+		std::istringstream file(std::string(mapped.data, mapped.size));
+		std::vector< glm::uvec2 > expanded_size(1);
+		std::vector< glm::u8vec4 > expanded;
+		if (!load_png(file, &expanded_size[0].x, &expanded_size[0].y, &expanded, origin)) {
+			throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
+		}
+		write_chunk("dim0", expanded_size, &out);
+		write_chunk("rgba", expanded, &out);
+	});
+	std::span< glm::uvec2 const > blob_size = blob->read_chunk< glm::uvec2 >("dim0");
+	std::span< glm::u8vec4 const > pixels = blob->read_chunk< glm::u8vec4 >("rgba");
+	if (blob_size.size() != 1 || size_t(blob_size[0].x) * blob_size[0].y != pixels.size()) {
+		throw std::runtime_error("Cached image for '" + filename + "' has the wrong size.");
 	}
+	*size = blob_size[0];
+	data->assign(pixels.begin(), pixels.end());
 }
 
 void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
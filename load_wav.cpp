@@ -1,4 +1,6 @@
 #include "load_wav.hpp"
+#include "asset_cache.hpp"
+#include "read_write_chunk.hpp"
 
 #include <SDL3/SDL.h>
 
@@ -8,7 +10,8 @@
 
 constexpr uint32_t AUDIO_RATE = 48000;
 
-void load_wav(std::string const &filename, std::vector< float > *data_) {
+//load + convert without the cache:
+static void convert_wav(std::string const &filename, std::vector< float > *data_) {
 	assert(data_);
 	auto &data = *data_;
 
@@ -16,7 +19,9 @@ void load_wav(std::string const &filename, std::vector< float > *data_) {
 	Uint8 *audio_buf = nullptr;
 	Uint32 audio_len = 0;
 
-	if (!SDL_LoadWAV(filename.c_str(), &audio_spec, &audio_buf, &audio_len)) {
+	//(read through MappedFile so the file can come from the asset pack)
+	MappedFile file(filename);
+	if (!SDL_LoadWAV_IO(SDL_IOFromConstMem(file.data, file.size), true, &audio_spec, &audio_buf, &audio_len)) {
 		throw std::runtime_error("Failed to load WAV file '" + filename + "'; SDL says \"" + std::string(SDL_GetError()) + "\"");
 	}
 	SDL_AudioSpec out_spec{ .format=SDL_AUDIO_F32, .channels=1, .freq=AUDIO_RATE };
@@ -54,3 +59,18 @@ void load_wav(std::string const &filename, std::vector< float > *data_) {
 	std::cout << "Range of " << filename << ": " << min << ", " << max << std::endl;
 	*/
 }
+
+void load_wav(std::string const &filename, std::vector< float > *data_) {
+	assert(data_);
+	auto &data = *data_;
+
+	//converted samples are kept in the asset cache:
+	// (bump the version if convert_wav's output changes)
+	std::unique_ptr< MappedFile > blob = cached_asset(filename, "wav-48k-f32-mono", 1, [&](std::ostream &out) {
+		std::vector< float > converted;
+		convert_wav(filename, &converted);
+		write_chunk("pcmf", converted, &out);
+	});
+	std::span< float const > samples = blob->read_chunk< float >("pcmf");
+	data.assign(samples.begin(), samples.end());
+}
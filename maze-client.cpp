@@ -3,6 +3,7 @@
 #include "Connection.hpp"
 #include "Mode.hpp"
 #include "Load.hpp"
+#include "Residency.hpp"
 #include "Sound.hpp"
 #include "GL.hpp"
 #include "load_save_png.hpp"
@@ -230,6 +231,9 @@ int main(int argc, char **argv) {
 
 			Mode::current->update(elapsed);
 			if (!Mode::current) break;
+
+			//finish any background asset loads and keep resident assets within budget:
+			Residency::update();
 		}
 
 		{ //(3) call the current mode's "draw" function to produce output:
@@ -0,0 +1,162 @@
+//net-bench: measures Server::poll() throughput for the select() and io_uring engines.
+//
+// Opens a Server on <port> that echoes everything it receives, then has a helper thread
+// open <connections> connections to it. Each round, the helper writes <bytes> on every
+// connection and then reads all the echoes back; the bench reports round trips per second
+// and how much CPU time the server (polling) thread used.
+//
+// (Server logs every accepted connection to stderr; run with 2>/dev/null for cleaner output.)
+// (There is no epoll engine in Connection.cpp, so select() is the only baseline.)
+
+#include "Connection.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#define closesocket close
+#endif
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+//CPU seconds (user + system) used by the calling thread, or -1.0 if not known on this platform:
+static double thread_cpu_seconds() {
+	#if defined(__linux__)
+	struct rusage usage;
+	if (getrusage(RUSAGE_THREAD, &usage) != 0) return -1.0;
+	return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+	     + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+	#else
+	return -1.0;
+	#endif
+}
+
+//connect, then do 'rounds' write-all-then-read-all rounds of 'bytes' per connection:
+static void run_clients(uint16_t port, uint32_t count, uint32_t rounds, uint32_t bytes, std::atomic< bool > *ok) {
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	std::vector< Socket > sockets;
+	auto fail = [&](char const *what) {
+		std::cerr << "(client thread: " << what << " failed: " << strerror(errno) << ")" << std::endl;
+		for (Socket s : sockets) closesocket(s);
+		*ok = false;
+	};
+
+	for (uint32_t i = 0; i < count; ++i) {
+		Socket s = socket(AF_INET, SOCK_STREAM, 0);
+		if (s == InvalidSocket) return fail("socket()");
+		if (connect(s, reinterpret_cast< struct sockaddr * >(&addr), sizeof(addr)) != 0) {
+			closesocket(s);
+			return fail("connect()");
+		}
+		int one = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast< char const * >(&one), sizeof(one));
+		sockets.emplace_back(s);
+	}
+
+	std::vector< char > out(bytes, 'x');
+	std::vector< char > in(bytes);
+	for (uint32_t round = 0; round < rounds; ++round) {
+		for (Socket s : sockets) {
+			for (size_t sent = 0; sent < out.size(); /* later */) {
+				auto ret = send(s, out.data() + sent, int(out.size() - sent), 0);
+				if (ret <= 0) return fail("send()");
+				sent += size_t(ret);
+			}
+		}
+		for (Socket s : sockets) {
+			for (size_t got = 0; got < in.size(); /* later */) {
+				auto ret = recv(s, in.data() + got, int(in.size() - got), 0);
+				if (ret <= 0) return fail("recv()");
+				got += size_t(ret);
+			}
+		}
+	}
+
+	for (Socket s : sockets) closesocket(s);
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2 || argc > 6) {
+		std::cerr << "Usage:\n\t./net-bench <port> [select|io_uring] [connections=64] [rounds=2000] [bytes=64]" << std::endl;
+		return 1;
+	}
+	uint16_t port = uint16_t(std::stoul(argv[1]));
+	std::string engine = (argc > 2 ? argv[2] : "select");
+	uint32_t count = (argc > 3 ? uint32_t(std::stoul(argv[3])) : 64);
+	uint32_t rounds = (argc > 4 ? uint32_t(std::stoul(argv[4])) : 2000);
+	uint32_t bytes = (argc > 5 ? uint32_t(std::stoul(argv[5])) : 64);
+
+	Server server(argv[1]);
+	if (engine == "io_uring") {
+		server.io_engine = IOEngine::IOUring;
+	} else if (engine != "select") {
+		std::cerr << "Unknown engine '" << engine << "' (expecting 'select' or 'io_uring')." << std::endl;
+		return 1;
+	}
+
+	std::cout << "net-bench: " << engine << ", " << count << " connections x " << rounds << " rounds x " << bytes << " bytes." << std::endl;
+
+	std::atomic< bool > ok(true);
+	std::thread clients(run_clients, port, count, rounds, bytes, &ok);
+
+	uint32_t opened = 0;
+	uint32_t closed = 0;
+	uint64_t echoed = 0;
+	uint64_t polls = 0;
+	//timing starts when the first connection shows up:
+	auto before = std::chrono::high_resolution_clock::now();
+	double cpu_before = 0.0;
+	while (closed < count && ok) {
+		server.poll([&](Connection *c, Connection::Event evt) {
+			if (evt == Connection::OnOpen) {
+				if (opened == 0) {
+					before = std::chrono::high_resolution_clock::now();
+					cpu_before = thread_cpu_seconds();
+				}
+				opened += 1;
+			} else if (evt == Connection::OnRecv) {
+				echoed += c->recv_buffer.size();
+				c->send_buffer.insert(c->send_buffer.end(), c->recv_buffer.begin(), c->recv_buffer.end());
+				c->recv_buffer.clear();
+			} else if (evt == Connection::OnClose) {
+				closed += 1;
+			}
+		}, 0.01);
+		polls += 1;
+	}
+	auto after = std::chrono::high_resolution_clock::now();
+	double cpu_after = thread_cpu_seconds();
+	clients.join();
+
+	if (!ok) return 1;
+
+	double seconds = std::chrono::duration< double >(after - before).count();
+	double round_trips = double(count) * double(rounds);
+	std::cout << "  " << round_trips / seconds << " round trips/s, " << (echoed / seconds) / (1024.0 * 1024.0) << " MiB/s echoed, "
+	          << polls << " polls in " << seconds * 1000.0 << " ms." << std::endl;
+	if (cpu_after >= 0.0) {
+		std::cout << "  server thread CPU: " << (cpu_after - cpu_before) * 1000.0 << " ms (" << 100.0 * (cpu_after - cpu_before) / seconds << "% of one core), "
+		          << 1e6 * (cpu_after - cpu_before) / round_trips << " us per round trip." << std::endl;
+	}
+
+	return 0;
+}
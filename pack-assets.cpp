@@ -0,0 +1,132 @@
+//pack-assets: bundle files into an asset pack (see AssetPack.hpp)
+//
+// Usage: pack-assets <out.pack> <directory> <file> [file ...]
+//  Files are named in the pack by their paths relative to <directory>
+//  (which should be the directory <out.pack> is loaded from, since that is
+//  where data_path() looks).
+//
+// Each file is LZ4-compressed if that makes it at least 1/8 smaller;
+//  otherwise (e.g., for already-compressed audio) it is stored as-is.
+
+#include "AssetPack.hpp"
+#include "asset_cache.hpp"
+#include "compress_lz4.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	if (argc < 4) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <out.pack> <directory> <file> [file ...]" << std::endl;
+		return 1;
+	}
+	std::filesystem::path out_path = argv[1];
+	std::filesystem::path directory = argv[2];
+
+	try {
+		struct Packed {
+			std::string name;
+			AssetPack::Entry entry;
+			std::vector< uint8_t > stored;
+		};
+		std::vector< Packed > packed;
+		std::string names;
+
+		for (int i = 3; i < argc; ++i) {
+			Packed p;
+			p.name = std::filesystem::relative(argv[i], directory).generic_string();
+			if (p.name.empty() || p.name.substr(0, 2) == "..") {
+				throw std::runtime_error("File '" + std::string(argv[i]) + "' is not inside '" + directory.string() + "'.");
+			}
+
+			MappedFile file(argv[i], MappedFile::FileOnly());
+			std::span< uint8_t const > contents(reinterpret_cast< uint8_t const * >(file.data), file.size);
+
+			p.entry = AssetPack::Entry{};
+			p.entry.name_hash = hash_bytes(p.name.data(), p.name.size());
+			p.entry.size = contents.size();
+			p.entry.checksum = hash_bytes(contents.data(), contents.size());
+			p.entry.name_begin = uint32_t(names.size());
+			names += p.name;
+			p.entry.name_end = uint32_t(names.size());
+
+			compress_lz4(contents, std::span< uint8_t const >(), &p.stored);
+			if (p.stored.size() <= contents.size() - contents.size() / 8) {
+				p.entry.compression = AssetPack::LZ4;
+			} else {
+				p.stored.assign(contents.begin(), contents.end());
+				p.entry.compression = AssetPack::Uncompressed;
+			}
+			p.entry.stored_size = p.stored.size();
+
+			packed.emplace_back(std::move(p));
+		}
+
+		std::sort(packed.begin(), packed.end(), [](Packed const &a, Packed const &b) {
+			return a.entry.name_hash < b.entry.name_hash;
+		});
+		for (size_t i = 1; i < packed.size(); ++i) {
+			if (packed[i].name == packed[i-1].name) throw std::runtime_error("File '" + packed[i].name + "' was listed twice.");
+		}
+
+		//lay out contents (in TOC order) after the header, each aligned:
+		auto align = [](uint64_t offset) {
+			return (offset + AssetPack::Alignment - 1) / AssetPack::Alignment * AssetPack::Alignment;
+		};
+		uint64_t offset = sizeof(AssetPack::Header);
+		for (auto &p : packed) {
+			p.entry.offset = align(offset);
+			offset = p.entry.offset + p.entry.stored_size;
+		}
+
+		AssetPack::Header header;
+		std::memcpy(header.magic, "pak0", 4);
+		header.count = uint32_t(packed.size());
+		header.entries_offset = align(offset);
+		header.names_offset = header.entries_offset + packed.size() * sizeof(AssetPack::Entry);
+		header.names_size = names.size();
+
+		std::filesystem::path temp = out_path;
+		temp += ".tmp";
+		{
+			std::ofstream out(temp, std::ios::binary);
+			auto pad_to = [&](uint64_t at) {
+				static char const zeros[AssetPack::Alignment] = { };
+				out.write(zeros, std::streamsize(at - uint64_t(out.tellp())));
+			};
+			out.write(reinterpret_cast< char const * >(&header), sizeof(header));
+			for (auto const &p : packed) {
+				pad_to(p.entry.offset);
+				out.write(reinterpret_cast< char const * >(p.stored.data()), std::streamsize(p.stored.size()));
+			}
+			pad_to(header.entries_offset);
+			for (auto const &p : packed) {
+				out.write(reinterpret_cast< char const * >(&p.entry), sizeof(p.entry));
+			}
+			out.write(names.data(), std::streamsize(names.size()));
+			if (!out) throw std::runtime_error("Failed to write '" + temp.string() + "'.");
+		}
+		std::filesystem::rename(temp, out_path);
+
+		uint64_t total_size = 0;
+		for (auto const &p : packed) {
+			std::cout << std::setw(32) << p.name << std::setw(10) << p.entry.size << " bytes";
+			if (p.entry.compression == AssetPack::LZ4) std::cout << " (lz4: " << p.entry.stored_size << ")";
+			std::cout << '\n';
+			total_size += p.entry.size;
+		}
+		std::cout << "Wrote " << packed.size() << " files (" << total_size << " bytes) to '" << out_path.string()
+		          << "' (" << std::filesystem::file_size(out_path) << " bytes)." << std::endl;
+
+	} catch (std::exception &e) {
+		std::cerr << "pack-assets: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
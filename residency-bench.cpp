@@ -0,0 +1,145 @@
+//residency-bench: does Resident<> stay within its budget, and what does it cost?
+//
+// Makes a set of Resident<>s (blocks of floats, each 'block' bytes), with a
+// budget that only fits some of them, then:
+//  - touches them all in order with get(), checking the budget holds and
+//    that the least-recently-used values are the ones evicted
+//  - holds one value while evicting everything, checking it stays resident
+//  - loads them all with try_get() + Residency::update(), as the client does
+//  - has one background load fail, checking update() doesn't throw,
+//    try_get() keeps returning the placeholder, and get() reports the error
+// Reports milliseconds for get() that loads, get() on resident values, and
+// background loads.
+//
+// usage: residency-bench [count [block-bytes]]
+
+#include "Residency.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+	size_t count = 256;
+	size_t block = 1024 * 1024;
+	if (argc > 1) count = std::stoul(argv[1]);
+	if (argc > 2) block = std::stoul(argv[2]);
+	if (count < 4) {
+		std::cerr << "Need at least 4 values." << std::endl;
+		return 1;
+	}
+
+	//room for a quarter of the values:
+	Residency::budget = (count / 4) * block;
+
+	std::atomic< size_t > loads = 0;
+	std::vector< std::unique_ptr< Resident< std::vector< float > > > > values;
+	for (size_t i = 0; i < count; ++i) {
+		values.emplace_back(std::make_unique< Resident< std::vector< float > > >([&loads, block, i]() {
+			++loads;
+			return new std::vector< float >(block / sizeof(float), float(i));
+		}, [](std::vector< float > const &data) {
+			return data.size() * sizeof(float);
+		}));
+	}
+
+	auto time = [](auto const &fn) {
+		auto before = std::chrono::high_resolution_clock::now();
+		fn();
+		return std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+	};
+
+	auto fail = [](std::string const &what) {
+		std::cerr << "FAILED: " << what << std::endl;
+		return 1;
+	};
+
+	//---- touch everything in order; only the most recent quarter should stay ----
+	bool correct = true;
+	double cold = time([&]() {
+		for (size_t i = 0; i < count; ++i) {
+			if (values[i]->get()->front() != float(i)) correct = false;
+		}
+	});
+	if (!correct) return fail("get() returned the wrong value");
+	if (loads != count) return fail("expected one load per value, got " + std::to_string(loads.load()));
+	if (Residency::used() > Residency::budget) return fail("over budget after loading");
+	for (size_t i = 0; i < count; ++i) {
+		bool should_be_resident = (i >= count - count / 4);
+		if (values[i]->resident() != should_be_resident) {
+			return fail("value " + std::to_string(i) + " should" + (should_be_resident ? "" : "n't") + " be resident");
+		}
+	}
+
+	//---- touching resident values shouldn't load anything ----
+	loads = 0;
+	double warm = time([&]() {
+		for (size_t i = count - count / 4; i < count; ++i) values[i]->get();
+	});
+	if (loads != 0) return fail("resident values were loaded again");
+
+	//---- values held elsewhere are never evicted ----
+	{
+		std::shared_ptr< std::vector< float > const > held = values[0]->get();
+		Residency::evict(0);
+		if (!values[0]->resident()) return fail("held value was evicted");
+		if (Residency::used() != block) return fail("unheld values were not evicted");
+	}
+	Residency::evict(0);
+	if (Residency::used() != 0) return fail("value still resident after it was released");
+
+	//---- background loads, finished by update() ----
+	std::shared_ptr< std::vector< float > const > placeholder = std::make_shared< std::vector< float > >();
+	for (auto &value : values) value->placeholder = placeholder;
+	size_t ready = 0;
+	double background = time([&]() {
+		while (ready < count / 4) {
+			ready = 0;
+			for (size_t i = 0; i < count / 4; ++i) {
+				if (values[i]->try_get() != placeholder) ++ready;
+			}
+			Residency::update();
+			std::this_thread::yield();
+		}
+	});
+	if (Residency::used() > Residency::budget) return fail("over budget after background loads");
+
+	//---- a failed background load ----
+	{
+		Resident< std::vector< float > > broken([]() -> std::vector< float > * {
+			throw std::runtime_error("(expected) broken value");
+		});
+		broken.placeholder = placeholder;
+		broken.try_get();
+		for (uint32_t frame = 0; frame < 1000 && !broken.failed; ++frame) {
+			try {
+				Residency::update();
+			} catch (std::exception const &) {
+				return fail("update() threw a background load's error");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if (broken.try_get() != placeholder) return fail("try_get() didn't return the placeholder after a failed load");
+		bool threw = false;
+		try {
+			broken.get();
+		} catch (std::exception const &) {
+			threw = true;
+		}
+		if (!threw) return fail("get() didn't report the failed load");
+	}
+
+	std::cout << "residency-bench: " << count << " values of " << block << " bytes, budget " << Residency::budget << " bytes." << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "  get(), loading:          " << std::setw(10) << 1e3 * cold << "ms (" << count << " values)" << std::endl;
+	std::cout << "  get(), resident:         " << std::setw(10) << 1e3 * warm << "ms (" << count / 4 << " values)" << std::endl;
+	std::cout << "  try_get() + update():    " << std::setw(10) << 1e3 * background << "ms (" << count / 4 << " values)" << std::endl;
+	std::cout << "all checks passed." << std::endl;
+
+	return 0;
+}
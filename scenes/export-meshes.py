@@ -3,6 +3,7 @@
 #based on 'export-sprites.py' and 'glsprite.py' from TCHOW Rainbow; code used is released into the public domain.
 #Patched for 15-466-f19 to remove non-pnct formats!
 #Patched for 15-466-f20 to merge data all at once (slightly faster)
+#Patched to also write indexed, vertex-cache-optimized '.ipnct' files
 
 #Note: Script meant to be executed within blender 4.2.1, as per:
 #blender --background --python export-meshes.py -- [...see below...]
@@ -15,7 +16,7 @@ for i in range(0,len(sys.argv)):
 		args = sys.argv[i+1:]
 
 if len(args) != 2:
-	print("\n\nUsage:\nblender --background --python export-meshes.py -- <infile.blend[:collection]> <outfile.pnct>\nExports the meshes referenced by all objects in the specified collection(s) (default: all objects) to a binary blob.\n")
+	print("\n\nUsage:\nblender --background --python export-meshes.py -- <infile.blend[:collection]> <outfile.pnct|outfile.ipnct>\nExports the meshes referenced by all objects in the specified collection(s) (default: all objects) to a binary blob.\n'.pnct' files are triangle soup; '.ipnct' files are indexed, with quantized normals/texcoords and triangles reordered for the vertex cache.\n")
 	exit(1)
 
 import bpy
@@ -28,7 +29,8 @@ if m:
 	collection_name = m.group(2)
 outfile = args[1]
 
-assert outfile.endswith(".pnct")
+assert outfile.endswith(".pnct") or outfile.endswith(".ipnct")
+indexed = outfile.endswith(".ipnct")
 
 print("Will export meshes referenced from ",end="")
 if collection_name:
@@ -38,6 +40,131 @@ else:
 print(" of '" + infile + "' to '" + outfile + "'.")
 
 import struct
+import collections
+
+#------------------------------------------------
+#Indexed export helpers:
+# meshes are deduplicated into vertices + triangles, then triangles are reordered with
+# "Tipsify" (Sander, Nehab, and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007)
+# so that the GPU's post-transform cache can reuse shaded vertices, and the resulting clusters are
+# ordered outside-in to reduce overdraw. Finally, vertices are renumbered in order of first use.
+
+CACHE_SIZE = 16 #post-transform cache size assumed for reordering and for the report
+
+#number of vertex shader invocations to draw 'indices' with a FIFO post-transform cache:
+def cache_misses(indices, cache_size=CACHE_SIZE):
+	cache = collections.deque()
+	in_cache = set()
+	misses = 0
+	for v in indices:
+		if v in in_cache: continue
+		misses += 1
+		cache.append(v)
+		in_cache.add(v)
+		if len(cache) > cache_size:
+			in_cache.discard(cache.popleft())
+	return misses
+
+#returns triangles (list of index triples) in cache-friendly order, split into clusters:
+def tipsify(triangles, vertex_count, cache_size=CACHE_SIZE):
+	adjacency = [[] for _ in range(vertex_count)]
+	for t, tri in enumerate(triangles):
+		for v in tri:
+			adjacency[v].append(t)
+	live = [len(a) for a in adjacency] #triangles not yet emitted, per vertex
+	timestamp = [0] * vertex_count #when each vertex last entered the cache
+	emitted = [False] * len(triangles)
+	dead_end = [] #recently used vertices, for when a fan runs out
+	time = cache_size + 1
+	cursor = 0
+
+	clusters = [[]]
+	fan = 0 if vertex_count > 0 else -1
+	while fan >= 0:
+		candidates = set()
+		for t in adjacency[fan]:
+			if emitted[t]: continue
+			emitted[t] = True
+			clusters[-1].append(triangles[t])
+			for v in triangles[t]:
+				dead_end.append(v)
+				candidates.add(v)
+				live[v] -= 1
+				if time - timestamp[v] > cache_size:
+					timestamp[v] = time
+					time += 1
+
+		#next fanning vertex: one still in the cache that will stay there while its remaining triangles are emitted:
+		fan = -1
+		best = -1
+		for v in candidates:
+			if live[v] > 0:
+				priority = 0
+				if time - timestamp[v] + 2 * live[v] <= cache_size:
+					priority = time - timestamp[v]
+				if priority > best:
+					best = priority
+					fan = v
+		if fan == -1:
+			#dead end -- restart from a recently used vertex, or the next unfinished one (a cluster boundary):
+			while dead_end and fan == -1:
+				v = dead_end.pop()
+				if live[v] > 0: fan = v
+			while fan == -1 and cursor < vertex_count:
+				if live[cursor] > 0: fan = cursor
+				else: cursor += 1
+			if clusters[-1]: clusters.append([])
+	if not clusters[-1]: clusters.pop()
+	return clusters
+
+#order clusters so ones facing away from the mesh center (likely in front) are drawn first:
+def order_clusters(clusters, positions):
+	def sub(a, b): return (a[0]-b[0], a[1]-b[1], a[2]-b[2])
+	def cross(a, b): return (a[1]*b[2]-a[2]*b[1], a[2]*b[0]-a[0]*b[2], a[0]*b[1]-a[1]*b[0])
+
+	center = [0.0, 0.0, 0.0]
+	for p in positions:
+		for c in range(3): center[c] += p[c]
+	center = [c / max(1, len(positions)) for c in center]
+
+	def outwardness(cluster):
+		area_normal = [0.0, 0.0, 0.0]
+		centroid = [0.0, 0.0, 0.0]
+		for tri in cluster:
+			a, b, c = positions[tri[0]], positions[tri[1]], positions[tri[2]]
+			n = cross(sub(b, a), sub(c, a))
+			for i in range(3):
+				area_normal[i] += n[i]
+				centroid[i] += (a[i] + b[i] + c[i]) / (3.0 * len(cluster))
+		d = sub(centroid, center)
+		return d[0]*area_normal[0] + d[1]*area_normal[1] + d[2]*area_normal[2]
+
+	return sorted(clusters, key=outwardness, reverse=True)
+
+#renumber vertices in order of first use (so vertex fetches walk memory in order):
+def renumber(triangles, vertex_count):
+	new_index = [-1] * vertex_count
+	order = []
+	out = []
+	for tri in triangles:
+		for v in tri:
+			if new_index[v] == -1:
+				new_index[v] = len(order)
+				order.append(v)
+			out.append(new_index[v])
+	return out, order
+
+#quantize: position as floats, normal as snorm16 (+ padding), color as unorm8, texcoord as half floats
+def pack_indexed_vertex(position, normal, color, uv):
+	def snorm16(x): return int(round(max(-1.0, min(1.0, x)) * 32767.0))
+	return struct.pack('fff', *position) \
+	     + struct.pack('hhhh', snorm16(normal[0]), snorm16(normal[1]), snorm16(normal[2]), 0) \
+	     + struct.pack('BBBB', *color) \
+	     + struct.pack('ee', *uv)
+INDEXED_VERTEX_SIZE = 4*3 + 2*4 + 1*4 + 2*2
+PNCT_VERTEX_SIZE = 4*3 + 4*3 + 1*4 + 4*2
+
+#------------------------------------------------
 
 bpy.ops.wm.open_mainfile(filepath=infile)
 
@@ -95,9 +222,14 @@ data = []
 strings = b''
 
 #index gives offsets into the data (and names) for each mesh:
+# (for indexed files, offsets into 'indices' rather than vertices)
 index = b''
 
 vertex_count = 0
+
+#indexed files only: element indices, plus counts for the report at the end:
+indices = []
+report = { 'triangles':0, 'vertices':0, 'misses_soup':0, 'misses_unoptimized':0, 'misses_optimized':0 }
 for obj in bpy.data.objects:
 	if obj.data in to_write:
 		to_write.remove(obj.data)
@@ -137,7 +269,7 @@ for obj in bpy.data.objects:
 	index += struct.pack('I', name_begin)
 	index += struct.pack('I', name_end)
 
-	index += struct.pack('I', vertex_count) #vertex_begin
+	index += struct.pack('I', len(indices) if indexed else vertex_count) #vertex_begin
 	#...count will be written below
 
 	colors = None
@@ -156,19 +288,14 @@ for obj in bpy.data.objects:
 		if len(obj.data.uv_layers) != 1:
 			print("WARNING: object '" + name + "' has multiple texture coordinate layers; only exporting '" + obj.data.uv_layers.active.name + "'")
 
-	local_data = b''
-
-	#write the mesh triangles:
+	#gather the mesh triangles:
+	corners = []
 	for poly in mesh.polygons:
 		assert(len(poly.loop_indices) == 3)
 		for i in range(0,3):
 			assert(mesh.loops[poly.loop_indices[i]].vertex_index == poly.vertices[i])
 			loop = mesh.loops[poly.loop_indices[i]]
 			vertex = mesh.vertices[loop.vertex_index]
-			for x in vertex.co:
-				local_data += struct.pack('f', x)
-			for x in loop.normal:
-				local_data += struct.pack('f', x)
 
 			col = None
 			if colors != None and colors.domain == 'POINT':
@@ -177,34 +304,87 @@ for obj in bpy.data.objects:
 				col = colors.data[poly.loop_indices[i]].color
 			else:
 				col = (1.0, 1.0, 1.0, 1.0)
-			local_data += struct.pack('BBBB', int(col[0] * 255), int(col[1] * 255), int(col[2] * 255), 255)
 
 			if uvs != None:
 				uv = uvs[poly.loop_indices[i]].uv
-				local_data += struct.pack('ff', uv.x, uv.y)
+				uv = (uv.x, uv.y)
 			else:
-				local_data += struct.pack('ff', 0, 0)
-		if len(local_data) > 1000:
-			data.append(local_data)
-			local_data = b''
-	vertex_count += len(mesh.polygons) * 3
-
-	data.append(local_data)
-
-	index += struct.pack('I', vertex_count) #vertex_end
+				uv = (0.0, 0.0)
+
+			corners.append((tuple(vertex.co), tuple(loop.normal), (int(col[0] * 255), int(col[1] * 255), int(col[2] * 255), 255), uv))
+
+	if not indexed:
+		#write the mesh triangles:
+		local_data = b''
+		for (position, normal, color, uv) in corners:
+			local_data += struct.pack('fff', *position)
+			local_data += struct.pack('fff', *normal)
+			local_data += struct.pack('BBBB', *color)
+			local_data += struct.pack('ff', *uv)
+			if len(local_data) > 1000:
+				data.append(local_data)
+				local_data = b''
+		vertex_count += len(mesh.polygons) * 3
+
+		data.append(local_data)
+
+		index += struct.pack('I', vertex_count) #vertex_end
+	else:
+		#deduplicate (after quantization, so near-identical vertices merge):
+		packed_index = dict()
+		packed = []
+		positions = []
+		corner_indices = []
+		for (position, normal, color, uv) in corners:
+			p = pack_indexed_vertex(position, normal, color, uv)
+			if p not in packed_index:
+				packed_index[p] = len(packed)
+				packed.append(p)
+				positions.append(position)
+			corner_indices.append(packed_index[p])
+		triangles = [tuple(corner_indices[i:i+3]) for i in range(0, len(corner_indices), 3)]
+
+		#reorder triangles for the vertex cache, then (by cluster) for overdraw, then vertices for fetch order:
+		clusters = order_clusters(tipsify(triangles, len(packed)), positions)
+		ordered = [tri for cluster in clusters for tri in cluster]
+		local_indices, order = renumber(ordered, len(packed))
+		assert(len(order) == len(packed))
+
+		report['triangles'] += len(triangles)
+		report['vertices'] += len(packed)
+		report['misses_soup'] += len(corner_indices)
+		report['misses_unoptimized'] += cache_misses(corner_indices)
+		report['misses_optimized'] += cache_misses(local_indices)
+
+		data.append(b''.join(packed[v] for v in order))
+		indices.extend(vertex_count + i for i in local_indices)
+		vertex_count += len(packed)
+
+		index += struct.pack('I', len(indices)) #vertex_end (== index_end)
 
 data = b''.join(data)
 
 #check that code created as much data as anticipated:
-assert(vertex_count * (4*3+4*3+1*4+4*2) == len(data))
+if indexed:
+	assert(vertex_count * INDEXED_VERTEX_SIZE == len(data))
+else:
+	assert(vertex_count * PNCT_VERTEX_SIZE == len(data))
 
 #write the data chunk and index chunk to an output blob:
 blob = open(outfile, 'wb')
 #first chunk: the data
-blob.write(struct.pack('4s',b'pnct')) #type
+blob.write(struct.pack('4s',b'ipnc' if indexed else b'pnct')) #type
 blob.write(struct.pack('I', len(data))) #length
 blob.write(data)
+if indexed:
+	#(indexed files only) element indices:
+	index_data = struct.pack(str(len(indices)) + 'I', *indices)
+	blob.write(struct.pack('4s',b'ind0')) #type
+	blob.write(struct.pack('I', len(index_data))) #length
+	blob.write(index_data)
 #second chunk: the strings
+#(padded to a multiple of four bytes so the chunks after it stay aligned for loading straight from a mapped file)
+strings += b'\0' * (-len(strings) % 4)
 blob.write(struct.pack('4s',b'str0')) #type
 blob.write(struct.pack('I', len(strings))) #length
 blob.write(strings)
@@ -215,4 +395,16 @@ blob.write(index)
 wrote = blob.tell()
 blob.close()
 
-print("Wrote " + str(wrote) + " bytes [== " + str(len(data)+8) + " bytes of data + " + str(len(strings)+8) + " bytes of strings + " + str(len(index)+8) + " bytes of index] to '" + outfile + "'")
\ No newline at end of file
+print("Wrote " + str(wrote) + " bytes [== " + str(len(data)+8) + " bytes of data + " + str(len(strings)+8) + " bytes of strings + " + str(len(index)+8) + " bytes of index] to '" + outfile + "'")
+
+if indexed:
+	t = max(1, report['triangles'])
+	soup_bytes = report['misses_soup'] * PNCT_VERTEX_SIZE
+	indexed_bytes = len(data) + 4 * len(indices)
+	print("Indexed export report (" + str(report['triangles']) + " triangles):")
+	print("  memory: " + str(soup_bytes) + " bytes as .pnct -> " + str(indexed_bytes) + " bytes (" + str(len(data)) + " vertex + " + str(4 * len(indices)) + " index) = " + "{:.1f}".format(100.0 * indexed_bytes / max(1, soup_bytes)) + "%")
+	print("  vertices: " + str(report['misses_soup']) + " -> " + str(report['vertices']) + " after deduplication")
+	print("  vertex shader invocations (FIFO cache of " + str(CACHE_SIZE) + "; per triangle):")
+	print("    .pnct: " + str(report['misses_soup']) + " (" + "{:.3f}".format(report['misses_soup'] / t) + ")")
+	print("    indexed, original order: " + str(report['misses_unoptimized']) + " (" + "{:.3f}".format(report['misses_unoptimized'] / t) + ")")
+	print("    indexed, reordered: " + str(report['misses_optimized']) + " (" + "{:.3f}".format(report['misses_optimized'] / t) + ")")
@@ -220,6 +220,8 @@ def write_chunk(magic, data):
 	blob.write(struct.pack('I', len(data))) #length
 	blob.write(data)
 
+#(strings are padded to a multiple of four bytes so the chunks after them stay aligned for loading straight from a mapped file)
+strings_data += b'\0' * (-len(strings_data) % 4)
 write_chunk(b'str0', strings_data)
 write_chunk(b'xfh0', xfh_data)
 write_chunk(b'msh0', mesh_data)
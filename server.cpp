@@ -4,11 +4,16 @@
 #include "hex_dump.hpp"
 
 #include "Game.hpp"
+#include "MessageDispatch.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <unordered_map>
 
 #ifdef _WIN32
@@ -32,11 +37,23 @@ int main(int argc, char **argv) {
 
 	//------------ argument parsing ------------
 
-	if (argc != 2) {
-		std::cerr << "Usage:\n\t./server <port>" << std::endl;
+	if (argc != 2 && argc != 3) {
+		std::cerr << "Usage:\n\t./server <port> [spectator-update-hz=10]" << std::endl;
 		return 1;
 	}
 
+	//spectators get state every 'spectator_interval' ticks (active players get it every tick):
+	uint32_t spectator_interval = 3;
+	if (argc == 3) {
+		float hz = std::stof(argv[2]);
+		if (!(hz > 0.0f)) {
+			std::cerr << "Spectator update rate must be positive." << std::endl;
+			return 1;
+		}
+		spectator_interval = std::max(1u, uint32_t(std::round(1.0f / (hz * Game::Tick))));
+	}
+	std::cout << "Sending state to spectators every " << spectator_interval << " tick(s)." << std::endl;
+
 	//------------ initialization ------------
 
 	Server server(argv[1]);
@@ -48,6 +65,48 @@ int main(int argc, char **argv) {
 	//keep track of game state:
 	Game game;
 
+	//handlers for messages from clients:
+	// (add more message types with more dispatch.on(...) calls)
+	MessageDispatch dispatch;
+	dispatch.on(Message::C2S_Controls, Player::Controls::PayloadSize, Player::Controls::PayloadSize,
+		[&](Connection *c, std::span< uint8_t const > payload) {
+			auto f = connection_to_player.find(c);
+			assert(f != connection_to_player.end());
+			f->second->controls.recv_controls_payload(payload);
+		}
+	);
+	dispatch.on(Message::C2S_Pause, 1, 1,
+		[&](Connection *c, std::span< uint8_t const > payload) {
+			auto f = connection_to_player.find(c);
+			assert(f != connection_to_player.end());
+			Player &player = *f->second;
+			bool paused = (payload[0] != 0);
+			if (player.paused && !paused) player.needs_state = true; //catch up right away
+			player.paused = paused;
+		}
+	);
+
+	dispatch.on(Message::C2S_Compression, 5, 5,
+		[&](Connection *c, std::span< uint8_t const > payload) {
+			auto f = connection_to_player.find(c);
+			assert(f != connection_to_player.end());
+			Player &player = *f->second;
+			uint32_t dictionary_id;
+			std::memcpy(&dictionary_id, payload.data() + 1, 4);
+			if (payload[0] == Game::CompressionLZ4 && dictionary_id == Game::state_dictionary_id()) {
+				player.compressed_state = true;
+			} else {
+				std::cout << "Client for " << player.name << " wants a compression scheme we don't have; sending uncompressed state." << std::endl;
+			}
+		}
+	);
+
+	//spectator state is serialized once per send and shared:
+	std::vector< uint8_t > spectator_state;
+	std::vector< uint8_t > spectator_state_compressed; //(made as needed)
+	std::vector< uint8_t > last_spectator_state; //(spectators only get state when it changes)
+	uint32_t tick = 0;
+
 	while (true) {
 		static auto next_tick = std::chrono::steady_clock::now() + std::chrono::duration< double >(Game::Tick);
 		//process incoming data from clients until a tick has elapsed:
@@ -83,19 +142,9 @@ int main(int argc, char **argv) {
 					//got data from client:
 					//std::cout << "current buffer:\n" << hex_dump(c->recv_buffer); std::cout.flush(); //DEBUG
 
-					//look up in players list:
-					auto f = connection_to_player.find(c);
-					assert(f != connection_to_player.end());
-					Player &player = *f->second;
-
-					//handle messages from client:
+					//handle (all complete) messages from client:
 					try {
-						bool handled_message;
-						do {
-							handled_message = false;
-							if (player.controls.recv_controls_message(c)) handled_message = true;
-							//TODO: extend for more message types as needed
-						} while (handled_message);
+						dispatch.dispatch(c);
 					} catch (std::exception const &e) {
 						std::cout << "Disconnecting client:" << e.what() << std::endl;
 						c->close();
@@ -108,9 +157,61 @@ int main(int argc, char **argv) {
 		//update current game state
 		game.update(Game::Tick);
 
-		//send updated game state to all clients
+		//send updated game state to clients, by update tier:
+		// - paused clients (not showing the game) get nothing
+		// - active players get their own state every tick (with their player first)
+		// - spectators share one serialized state, sent every spectator_interval ticks if it changed
+		// (state is LZ4-compressed for clients that sent C2S_Compression)
+		tick += 1;
+		bool spectator_tick = (tick % spectator_interval == 0);
+		bool spectator_state_built = false;
+		bool spectator_state_changed = false;
+		//NOTE: client marks the first player as "you" when it is active, so lead with a spectator --
+		// always the longest-connected one (players are kept in join order), so the state doesn't
+		// change just because connection_to_player iterated in a different order:
+		Player const *first_spectator = nullptr;
+		for (auto const &p : game.players) {
+			if (!p.activePlayer) {
+				first_spectator = &p;
+				break;
+			}
+		}
 		for (auto &[c, player] : connection_to_player) {
-			game.send_state_message(c, player);
+			if (player->paused) continue;
+
+			if (player->activePlayer) {
+				if (player->compressed_state) game.append_compressed_state_message(&c->send_buffer, player);
+				else game.send_state_message(c, player);
+				player->needs_state = false;
+				continue;
+			}
+
+			if (!spectator_tick && !player->needs_state) continue;
+			if (!spectator_state_built) {
+				spectator_state.clear();
+				game.append_state_message(&spectator_state, first_spectator);
+				//tugClockTimer (sent last) is left out of the comparison: it only moves along with
+				// progress / matchState, so it goes out with those changes anyway:
+				size_t const clock_size = sizeof(game.tugClockTimer);
+				spectator_state_changed = (spectator_state.size() != last_spectator_state.size()
+					|| !std::equal(spectator_state.begin(), spectator_state.end() - clock_size, last_spectator_state.begin()));
+				spectator_state_built = true;
+				spectator_state_compressed.clear();
+			}
+			if (!spectator_state_changed && !player->needs_state) continue;
+
+			if (player->compressed_state) {
+				if (spectator_state_compressed.empty()) {
+					game.append_compressed_state_message(&spectator_state_compressed, first_spectator);
+				}
+				c->send_buffer.insert(c->send_buffer.end(), spectator_state_compressed.begin(), spectator_state_compressed.end());
+			} else {
+				c->send_buffer.insert(c->send_buffer.end(), spectator_state.begin(), spectator_state.end());
+			}
+			player->needs_state = false;
+		}
+		if (spectator_tick && spectator_state_changed) {
+			std::swap(spectator_state, last_spectator_state);
 		}
 
 	}
@@ -2,6 +2,7 @@
 #include "ShowSceneMode.hpp"
 #include "Load.hpp"
 #include "GL.hpp"
+#include "gl_indirect.hpp"
 #include "load_save_png.hpp"
 #include "ShowSceneProgram.hpp"
 
@@ -67,6 +68,8 @@ int main(int argc, char **argv) {
 
 	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
 	init_GL();
+	//(optional; Scene::draw uses multi-draw-indirect when available)
+	init_GL_indirect();
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
 	if (!SDL_GL_SetSwapInterval(-1)) {
@@ -110,7 +113,7 @@ int main(int argc, char **argv) {
 	if (scene_file != "") {
 		try {
 			scene = new Scene();
-			scene->load(scene_file, [&buffer,&buffer_vao](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
+			scene->load(scene_file, [&buffer,&buffer_vao](Scene &scene, uint32_t transform, std::string const &mesh_name){
 				if (!buffer_vao) return;
 				Mesh const &mesh = buffer->lookup(mesh_name);
 
@@ -123,6 +126,10 @@ int main(int argc, char **argv) {
 				drawable.pipeline.type = mesh.type;
 				drawable.pipeline.start = mesh.start;
 				drawable.pipeline.count = mesh.count;
+				drawable.pipeline.index_type = mesh.index_type;
+
+				drawable.min = mesh.min;
+				drawable.max = mesh.max;
 
 			});
 		} catch (std::exception &e) {
@@ -0,0 +1,92 @@
+//snapshot-bench: how much does compressing S2C_State messages save, and what does it cost?
+//
+// Builds state messages for games with 2 players and 0..N spectators (with the progress / penalty
+// values changing every tick, as in a match), then reports average message size uncompressed,
+// LZ4-compressed with and without the shared dictionary, and the time per tick spent compressing
+// (including serializing the message) and decompressing.
+//
+// (Times are per message; a server compresses once per active player plus once per spectator tier per tick.)
+
+#include "Game.hpp"
+#include "compress_lz4.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+
+int main(int argc, char **argv) {
+	if (argc > 2) {
+		std::cerr << "Usage:\n\t./snapshot-bench [ticks=3000]" << std::endl;
+		return 1;
+	}
+	uint32_t ticks = (argc > 1 ? uint32_t(std::stoul(argv[1])) : 3000);
+
+	std::vector< uint8_t > const &dictionary = Game::state_dictionary();
+	std::cout << "snapshot-bench: " << ticks << " ticks per row, dictionary is " << dictionary.size() << " bytes." << std::endl;
+	std::cout << std::setw(11) << "spectators" << std::setw(10) << "raw B" << std::setw(10) << "lz4 B" << std::setw(10) << "+dict B"
+	          << std::setw(10) << "ratio" << std::setw(14) << "compress us" << std::setw(16) << "decompress us" << std::endl;
+
+	for (uint32_t spectators : {0, 4, 16, 64, 200}) {
+		Game game;
+		Player::activePlayerCount = 2;
+		for (uint32_t i = 1; i <= 2 + spectators; ++i) {
+			game.players.emplace_back();
+			Player &player = game.players.back();
+			player.name = "Player " + std::to_string(i);
+			player.playerNumber = int(i);
+			player.activePlayer = (i <= 2);
+			player.advantageDirection = (i == 1 ? -1 : (i == 2 ? 1 : 0));
+		}
+		Player *first = &game.players.back();
+
+		uint64_t raw_bytes = 0, plain_bytes = 0, dict_bytes = 0;
+		double compress_seconds = 0.0, decompress_seconds = 0.0;
+		std::vector< uint8_t > raw, plain, packed, unpacked;
+		for (uint32_t tick = 0; tick < ticks; ++tick) {
+			//move the match along a bit:
+			game.progress = 3.0f * std::sin(tick * 0.01f);
+			game.tugClockTimer = int(tick / 30) % 5;
+			game.players.front().penalty = (tick % 200 < 50 ? float(tick % 50) * 0.1f : 0.0f);
+
+			raw.clear();
+			game.append_state_message(&raw, first);
+			std::span< uint8_t const > payload = std::span< uint8_t const >(raw).subspan(4);
+			raw_bytes += raw.size();
+
+			plain.clear();
+			compress_lz4(payload, std::span< uint8_t const >(), &plain);
+			plain_bytes += 4 + 4 + plain.size();
+
+			auto before = std::chrono::high_resolution_clock::now();
+			packed.clear();
+			game.append_compressed_state_message(&packed, first);
+			auto after = std::chrono::high_resolution_clock::now();
+			compress_seconds += std::chrono::duration< double >(after - before).count();
+			dict_bytes += packed.size();
+
+			if (packed[0] == uint8_t(Message::S2C_StateCompressed)) {
+				auto before = std::chrono::high_resolution_clock::now();
+				decompress_lz4(std::span< uint8_t const >(packed).subspan(8), dictionary, payload.size(), &unpacked);
+				auto after = std::chrono::high_resolution_clock::now();
+				decompress_seconds += std::chrono::duration< double >(after - before).count();
+				if (!std::equal(unpacked.begin(), unpacked.end(), payload.begin(), payload.end())) {
+					std::cerr << "Round trip failed!" << std::endl;
+					return 1;
+				}
+			}
+		}
+
+		std::cout << std::setw(11) << spectators
+		          << std::setw(10) << raw_bytes / ticks
+		          << std::setw(10) << plain_bytes / ticks
+		          << std::setw(10) << dict_bytes / ticks
+		          << std::setw(10) << std::setprecision(3) << double(raw_bytes) / double(dict_bytes)
+		          << std::setw(14) << std::setprecision(3) << 1e6 * compress_seconds / ticks
+		          << std::setw(16) << std::setprecision(3) << 1e6 * decompress_seconds / ticks << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+//transform-bench: how fast are world_from_local matrices computed one-at-a-time vs. in batches?
+//
+// Builds a scene with N animated transforms (a quarter are roots, the rest are children of
+// earlier transforms), then moves every transform each frame and times:
+//  - 'single': make_parent_from_local + parent multiply, one transform at a time (the old path)
+//  - 'batch': make_parent_from_local_batch + make_world_from_local_batch over all transforms
+//  - 'update': Scene::update_world_from_local (change detection + batch)
+// and checks that the batch results match the single-transform results.
+
+#include "Scene.hpp"
+#include "transform_batch.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+
+int main(int argc, char **argv) {
+	if (argc > 2) {
+		std::cerr << "Usage:\n\t./transform-bench [frames=2000]" << std::endl;
+		return 1;
+	}
+	uint32_t frames = (argc > 1 ? uint32_t(std::stoul(argv[1])) : 2000);
+
+	std::cout << "transform-bench: " << frames << " frames per row." << std::endl;
+	std::cout << std::setw(11) << "transforms" << std::setw(14) << "single ns/xf" << std::setw(14) << "batch ns/xf"
+	          << std::setw(15) << "update ns/xf" << std::setw(10) << "speedup" << std::setw(12) << "max error" << std::endl;
+
+	for (uint32_t count : {64, 256, 1024, 4096}) {
+		Scene scene;
+		Scene::Transforms &transforms = scene.transforms;
+		std::mt19937 mt(0x15466);
+		auto rand01 = [&]() { return mt() / float(mt.max()); };
+		for (uint32_t i = 0; i < count; ++i) {
+			uint32_t parent = (i < count / 4 ? Scene::NoTransform : mt() % i);
+			uint32_t t = transforms.add("xf" + std::to_string(i), parent);
+			transforms.positions[t] = glm::vec3(rand01(), rand01(), rand01()) * 4.0f - 2.0f;
+			transforms.rotations[t] = glm::normalize(glm::quat(rand01(), rand01(), rand01(), rand01()));
+			transforms.scales[t] = glm::vec3(0.5f + rand01());
+		}
+
+		std::vector< uint32_t > all(count);
+		for (uint32_t i = 0; i < count; ++i) all[i] = i;
+		std::vector< glm::mat4x3 > single(count), parent_from_local(count), world_from_local(count);
+
+		auto animate = [&](uint32_t frame) {
+			for (uint32_t i = 0; i < count; ++i) {
+				transforms.positions[i].z = 0.01f * std::sin(0.01f * float(frame + i));
+			}
+		};
+
+		double single_seconds = 0.0, batch_seconds = 0.0, update_seconds = 0.0;
+		float max_error = 0.0f;
+		for (uint32_t frame = 0; frame < frames; ++frame) {
+			animate(frame);
+
+			{ //one at a time:
+				auto before = std::chrono::high_resolution_clock::now();
+				for (uint32_t i = 0; i < count; ++i) {
+					glm::mat4x3 local = transforms.make_parent_from_local(i);
+					uint32_t parent = transforms.parents[i];
+					single[i] = (parent == Scene::NoTransform ? local : single[parent] * glm::mat4(local));
+				}
+				auto after = std::chrono::high_resolution_clock::now();
+				single_seconds += std::chrono::duration< double >(after - before).count();
+			}
+
+			{ //batched:
+				auto before = std::chrono::high_resolution_clock::now();
+				make_parent_from_local_batch(count, all.data(), transforms.positions.data(), transforms.rotations.data(), transforms.scales.data(), parent_from_local.data());
+				make_world_from_local_batch(count, all.data(), transforms.parents.data(), parent_from_local.data(), world_from_local.data());
+				auto after = std::chrono::high_resolution_clock::now();
+				batch_seconds += std::chrono::duration< double >(after - before).count();
+			}
+
+			{ //through the scene's cache:
+				auto before = std::chrono::high_resolution_clock::now();
+				scene.update_world_from_local();
+				auto after = std::chrono::high_resolution_clock::now();
+				update_seconds += std::chrono::duration< double >(after - before).count();
+			}
+
+			if (frame == 0 || frame + 1 == frames) {
+				for (uint32_t i = 0; i < count; ++i) {
+					for (uint32_t c = 0; c < 4; ++c) {
+						for (uint32_t r = 0; r < 3; ++r) {
+							max_error = std::max(max_error, std::abs(single[i][c][r] - world_from_local[i][c][r]));
+							max_error = std::max(max_error, std::abs(single[i][c][r] - transforms.world_from_local[i][c][r]));
+						}
+					}
+				}
+			}
+		}
+
+		double scale = 1e9 / (double(frames) * double(count));
+		std::cout << std::setw(11) << count
+		          << std::setw(14) << std::setprecision(3) << single_seconds * scale
+		          << std::setw(14) << std::setprecision(3) << batch_seconds * scale
+		          << std::setw(15) << std::setprecision(3) << update_seconds * scale
+		          << std::setw(10) << std::setprecision(3) << single_seconds / batch_seconds
+		          << std::setw(12) << std::setprecision(3) << max_error << std::endl;
+
+		if (max_error > 1e-4f) {
+			std::cerr << "Batch results differ from single-transform results!" << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,211 @@
+#include "transform_batch.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_BATCH_SSE 1
+#include <xmmintrin.h>
+#endif
+
+static_assert(sizeof(glm::mat4x3) == 12 * sizeof(float), "mat4x3 is 12 packed floats.");
+
+//The math is written once, over a 'lanes' type that is either a float (one transform)
+// or an __m128 (four transforms); these helpers paper over the difference:
+static inline float add(float a, float b) { return a + b; }
+static inline float sub(float a, float b) { return a - b; }
+static inline float mul(float a, float b) { return a * b; }
+static inline float splat(float a, float *) { return a; }
+
+#ifdef TRANSFORM_BATCH_SSE
+static inline __m128 add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+static inline __m128 sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+static inline __m128 mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+static inline __m128 splat(float a, __m128 *) { return _mm_set1_ps(a); }
+#endif
+
+//matrices are handled as 12 values in glm's (column-major) order; element 3*c+r is column c, row r.
+
+//q is (x,y,z,w); same as glm::mat3_cast, with columns scaled by s:
+template< typename L >
+static inline void compose(L const q[4], L const p[3], L const s[3], L out[12]) {
+	L one = splat(1.0f, (L *)nullptr);
+	L two = splat(2.0f, (L *)nullptr);
+
+	L xx = mul(q[0], q[0]), yy = mul(q[1], q[1]), zz = mul(q[2], q[2]);
+	L xy = mul(q[0], q[1]), xz = mul(q[0], q[2]), yz = mul(q[1], q[2]);
+	L wx = mul(q[3], q[0]), wy = mul(q[3], q[1]), wz = mul(q[3], q[2]);
+
+	out[0] = mul(sub(one, mul(two, add(yy, zz))), s[0]);
+	out[1] = mul(mul(two, add(xy, wz)), s[0]);
+	out[2] = mul(mul(two, sub(xz, wy)), s[0]);
+
+	out[3] = mul(mul(two, sub(xy, wz)), s[1]);
+	out[4] = mul(sub(one, mul(two, add(xx, zz))), s[1]);
+	out[5] = mul(mul(two, add(yz, wx)), s[1]);
+
+	out[6] = mul(mul(two, add(xz, wy)), s[2]);
+	out[7] = mul(mul(two, sub(yz, wx)), s[2]);
+	out[8] = mul(sub(one, mul(two, add(xx, yy))), s[2]);
+
+	out[9] = p[0];
+	out[10] = p[1];
+	out[11] = p[2];
+}
+
+//out = a * b, treating both as affine 4x4 matrices with an implied (0,0,0,1) row:
+template< typename L >
+static inline void multiply(L const a[12], L const b[12], L out[12]) {
+	for (uint32_t c = 0; c < 4; ++c) {
+		for (uint32_t r = 0; r < 3; ++r) {
+			L v = mul(a[0 + r], b[3*c + 0]);
+			v = add(v, mul(a[3 + r], b[3*c + 1]));
+			v = add(v, mul(a[6 + r], b[3*c + 2]));
+			if (c == 3) v = add(v, a[9 + r]);
+			out[3*c + r] = v;
+		}
+	}
+}
+
+static inline void load(glm::mat4x3 const &m, float out[12]) {
+	float const *f = glm::value_ptr(m);
+	for (uint32_t e = 0; e < 12; ++e) out[e] = f[e];
+}
+static inline void store(float const in[12], glm::mat4x3 *m) {
+	float *f = glm::value_ptr(*m);
+	for (uint32_t e = 0; e < 12; ++e) f[e] = in[e];
+}
+
+#ifdef TRANSFORM_BATCH_SSE
+//load four matrices into twelve registers, one matrix per lane:
+static inline void load4(glm::mat4x3 const *m[4], __m128 out[12]) {
+	for (uint32_t row = 0; row < 3; ++row) {
+		__m128 a = _mm_loadu_ps(glm::value_ptr(*m[0]) + 4 * row);
+		__m128 b = _mm_loadu_ps(glm::value_ptr(*m[1]) + 4 * row);
+		__m128 c = _mm_loadu_ps(glm::value_ptr(*m[2]) + 4 * row);
+		__m128 d = _mm_loadu_ps(glm::value_ptr(*m[3]) + 4 * row);
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		out[4 * row + 0] = a;
+		out[4 * row + 1] = b;
+		out[4 * row + 2] = c;
+		out[4 * row + 3] = d;
+	}
+}
+static inline void store4(__m128 const in[12], glm::mat4x3 *m[4]) {
+	for (uint32_t row = 0; row < 3; ++row) {
+		__m128 a = in[4 * row + 0];
+		__m128 b = in[4 * row + 1];
+		__m128 c = in[4 * row + 2];
+		__m128 d = in[4 * row + 3];
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(glm::value_ptr(*m[0]) + 4 * row, a);
+		_mm_storeu_ps(glm::value_ptr(*m[1]) + 4 * row, b);
+		_mm_storeu_ps(glm::value_ptr(*m[2]) + 4 * row, c);
+		_mm_storeu_ps(glm::value_ptr(*m[3]) + 4 * row, d);
+	}
+}
+#endif
+
+void make_parent_from_local_batch(
+	uint32_t count, uint32_t const *indices,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *parent_from_local) {
+
+	uint32_t i = 0;
+
+#ifdef TRANSFORM_BATCH_SSE
+	for (; i + 4 <= count; i += 4) {
+		uint32_t const *idx = indices + i;
+
+		glm::quat const &q0 = rotations[idx[0]], &q1 = rotations[idx[1]], &q2 = rotations[idx[2]], &q3 = rotations[idx[3]];
+		__m128 q[4] = {
+			_mm_setr_ps(q0.x, q0.y, q0.z, q0.w),
+			_mm_setr_ps(q1.x, q1.y, q1.z, q1.w),
+			_mm_setr_ps(q2.x, q2.y, q2.z, q2.w),
+			_mm_setr_ps(q3.x, q3.y, q3.z, q3.w),
+		};
+		_MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+
+		__m128 p[3], s[3];
+		for (uint32_t k = 0; k < 3; ++k) {
+			p[k] = _mm_setr_ps(positions[idx[0]][k], positions[idx[1]][k], positions[idx[2]][k], positions[idx[3]][k]);
+			s[k] = _mm_setr_ps(scales[idx[0]][k], scales[idx[1]][k], scales[idx[2]][k], scales[idx[3]][k]);
+		}
+
+		__m128 m[12];
+		compose(q, p, s, m);
+
+		glm::mat4x3 *out[4] = {
+			&parent_from_local[idx[0]], &parent_from_local[idx[1]], &parent_from_local[idx[2]], &parent_from_local[idx[3]]
+		};
+		store4(m, out);
+	}
+#endif
+
+	for (; i < count; ++i) {
+		uint32_t t = indices[i];
+		float q[4] = { rotations[t].x, rotations[t].y, rotations[t].z, rotations[t].w };
+		float p[3] = { positions[t].x, positions[t].y, positions[t].z };
+		float s[3] = { scales[t].x, scales[t].y, scales[t].z };
+		float m[12];
+		compose(q, p, s, m);
+		store(m, &parent_from_local[t]);
+	}
+}
+
+void make_world_from_local_batch(
+	uint32_t count, uint32_t const *indices, uint32_t const *parents,
+	glm::mat4x3 const *parent_from_local,
+	glm::mat4x3 *world_from_local) {
+
+	static glm::mat4x3 const identity = glm::mat4x3(1.0f);
+
+	auto one = [&](uint32_t t) {
+		if (parents[t] == -1U) {
+			world_from_local[t] = parent_from_local[t];
+		} else {
+			float a[12], b[12], m[12];
+			load(world_from_local[parents[t]], a);
+			load(parent_from_local[t], b);
+			multiply(a, b, m);
+			store(m, &world_from_local[t]);
+		}
+	};
+
+	uint32_t i = 0;
+
+#ifdef TRANSFORM_BATCH_SSE
+	for (; i + 4 <= count; i += 4) {
+		uint32_t const *idx = indices + i;
+
+		//a transform whose parent is earlier in the same group would read a stale matrix, so do those groups one at a time:
+		bool dependent = false;
+		for (uint32_t j = 1; j < 4; ++j) {
+			for (uint32_t k = 0; k < j; ++k) {
+				if (parents[idx[j]] == idx[k]) dependent = true;
+			}
+		}
+		if (dependent) {
+			for (uint32_t j = 0; j < 4; ++j) one(idx[j]);
+			continue;
+		}
+
+		glm::mat4x3 const *parent[4], *local[4];
+		glm::mat4x3 *out[4];
+		for (uint32_t j = 0; j < 4; ++j) {
+			parent[j] = (parents[idx[j]] == -1U ? &identity : &world_from_local[parents[idx[j]]]);
+			local[j] = &parent_from_local[idx[j]];
+			out[j] = &world_from_local[idx[j]];
+		}
+
+		__m128 a[12], b[12], m[12];
+		load4(parent, a);
+		load4(local, b);
+		multiply(a, b, m);
+		store4(m, out);
+	}
+#endif
+
+	for (; i < count; ++i) {
+		one(indices[i]);
+	}
+}
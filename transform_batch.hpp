@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+/*
+ * Batch versions of the per-transform matrix math in Scene::Transforms,
+ *  used by Scene::Transforms::update_world_from_local().
+ *
+ * Transforms are handled four at a time with SSE (when available) by
+ *  transposing them into one-lane-per-transform registers; leftovers, and
+ *  builds without SSE, use the same math one transform at a time.
+ *
+ * Both functions take a list of 'indices' so that only changed transforms
+ *  need to be touched; the arrays are indexed by transform.
+ */
+
+//parent_from_local[i] = translate(positions[i]) * rotate(rotations[i]) * scale(scales[i]) for each i in indices:
+void make_parent_from_local_batch(
+	uint32_t count, uint32_t const *indices,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *parent_from_local
+);
+
+//world_from_local[i] = world_from_local[parents[i]] * parent_from_local[i] for each i in indices, in order:
+// (parents[i] == -1U means world_from_local[i] = parent_from_local[i])
+//NOTE: indices must be in parents-first order, so every parent's world_from_local is final before its children use it
+void make_world_from_local_batch(
+	uint32_t count, uint32_t const *indices, uint32_t const *parents,
+	glm::mat4x3 const *parent_from_local,
+	glm::mat4x3 *world_from_local
+);